@@ -11,12 +11,16 @@
 #define FERR_GRAPHNET_IMPLEMENT
 #include "ferr_graphnet.h"
 */
+// The file parser uses SSE2 or AVX2 when the compiler has  //
+// them enabled, #define FERR_GRAPHNET_NO_SIMD to turn that //
+// off and use plain C++ instead.                          //
 //                  __|BASIC USAGE|__                      //
 //                                                         //
 // Here's a quick example of fgn loading and displaying a  //
 // file! You can load from the file system via             //
 // fgn_load_file, or from  a string you already have via   //
-// fgn_load.                                               //
+// fgn_load. Big files can use fgn_load_file_mapped, which //
+// points strings into the mapped file instead of copying. //
 /*
 
 fgn_library_t lib = {};
@@ -25,10 +29,11 @@ fgn_load_file(lib, "out_proc.fgn");
 fgn_lib_each(lib, [](fgn_graph_t &graph)
 {
 	printf("Graph - %s\n", graph.id);
-	fgn_graph_node_each(graph, [](auto g, fgn_node_t &node)
+	for (int i = 0, ct = fgn_graph_node_count(graph); i < ct; i += 1)
 	{
-		printf("%s: [in:%d, out:%d, keys:%d]\n", node.id, node.in_ct, node.out_ct, node.data.pair_ct);
-	});
+		fgn_node_t &node = fgn_graph_node_get(graph, i);
+		printf("%s: [in:%d, out:%d, keys:%d]\n", node.id, fgn_graph_node_in_count(graph, i), fgn_graph_node_out_count(graph, i), fgn_graph_node_pair_count(graph, i));
+	}
 });
 
 fgn_destroy(lib);
@@ -46,11 +51,11 @@ fgn_data_add(graph.data, "desc", "Key value pairs can even contain\nnew lines an
 fgn_graph_idx n1 = fgn_graph_node_add(graph, "Start");
 fgn_graph_idx n2 = fgn_graph_node_add(graph, "Middle");
 fgn_graph_idx n3 = fgn_graph_node_add(graph, "End");
-fgn_data_add(fgn_graph_node_get(graph, n2).data, "cost", "100");
+fgn_data_add(fgn_graph_node_pairs(graph, n2), "cost", "100");
 
 fgn_graph_idx e1 = fgn_graph_edge_add(graph, n1, n2);
 fgn_graph_idx e2 = fgn_graph_edge_add(graph, "Start", "End");
-fgn_data_add(fgn_graph_edge_get(graph, e2).data, "distance", "5.1");
+fgn_data_add(fgn_graph_edge_pairs(graph, e2), "distance", "5.1");
 
 char *text_graph = fgn_save(graph);
 printf("Output file:\n%s", text_graph);
@@ -104,6 +109,31 @@ fgn_destroy(node_parser);
 // v1.0 - 2019-10                                          //
 // - Initial version! Put it to good use :)                //
 //                                                         //
+// v1.1 - 2026-10                                          //
+// - fgn_edge_t.data is gone, edges keep their pairs off   //
+//   to the side, get them with fgn_graph_edge_pairs.      //
+// - fgn_node_t.data is gone too, nodes keep their pairs   //
+//   in the same kind of side table, get them with         //
+//   fgn_graph_node_pairs.                                 //
+// - fgn_graph_node_data/edge_data take a non-const graph  //
+//   now, since asking can set up or parse structs. Const  //
+//   graphs get overloads that only read parsed structs.   //
+// - Built-in fgn_write_ functions write into a buffer,    //
+//   snprintf style, returning the length rather than a    //
+//   malloc'd string. Parsers built with them need no      //
+//   changes, and custom char* writers still work through  //
+//   fgn_parser_add.                                       //
+// - A node's id_hash, position, in_ct and out_ct moved    //
+//   off fgn_node_t into columns on the graph. Use         //
+//   fgn_graph_node_hash, fgn_graph_node_position,         //
+//   fgn_graph_node_in_count and fgn_graph_node_out_count. //
+// - fgn_graph_edge_delete moves the last edge into the    //
+//   gap instead of shifting the rest down, so edge order  //
+//   changes, and returns the moved edge's old index.      //
+// - With fgn_graph_use_handles on, fgn_graph_node_delete  //
+//   does the same for nodes. Without handles, nodes keep  //
+//   their order like before.                              //
+//                                                         //
 //                    __|LICENSE|__                        //
 //
 // MIT License
@@ -132,6 +162,7 @@ fgn_destroy(node_parser);
 #define FERR_GRAPHNET_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
@@ -143,6 +174,14 @@ typedef int32_t  fgn_node_idx;
 typedef int32_t  fgn_edge_idx;
 typedef uint64_t fgn_hash_t;
 
+// How many in and out edges a node keeps inside itself before its edge
+// lists move out to their own allocation
+#define _FGN_INLINE_EDGES 3
+
+// Pair lists longer than this get a hash index for key lookups, shorter
+// ones are just scanned
+#define _FGN_DATA_INDEX_MIN 8
+
 // Core graph data types
 struct fgn_library_t;
 struct fgn_graph_t;
@@ -152,6 +191,20 @@ struct fgn_edge_t;
 // User-defined data storage and key/value pairs
 struct fgn_data_t;
 struct _fgn_pair_t;
+struct _fgn_structs_t;
+
+// Memory owned by a library, like mapped files
+struct _fgn_mem_t;
+
+// Where saves write to
+struct _fgn_out_t;
+
+// Stable handles to nodes and edges, for graphs that opt in
+struct fgn_handle_t;
+struct _fgn_slots_t;
+
+// Read-only compressed adjacency snapshot of a graph
+struct fgn_frozen_t;
 
 // Parsing info for turning key/value pairs into structs
 struct fgn_parser_t;
@@ -173,12 +226,39 @@ struct _fgn_pair_t {
 	char      *key;
 	char      *value;
 };
+// Every pair list is allocated with one of these right before its
+// first pair, so the bookkeeping only costs lists that have pairs.
+struct _fgn_pairs_head_t {
+	// Memory a borrowed list lives in, nullptr for owned lists
+	_fgn_mem_t *mem;
+	// Library memory that loaded keys were interned in, if any
+	_fgn_mem_t *key_mem;
+	// Hash index for key lookups on longer lists, built on first use.
+	// index[0] is the capacity, then a pair_idx+1 or 0 for each slot.
+	// Borrowed lists keep a stale index around as ~capacity, for reuse.
+	int32_t    *index;
+};
+struct _fgn_structs_t {
+	uint8_t *data;
+	int32_t  size; // Bytes per struct, 0 while unused
+	int32_t  cap;
+
+	// Set by fgn_parse_lazy, one flag per struct for whether its pairs
+	// have been parsed into it yet. nullptr once everything's parsed.
+	const fgn_parser_t *parser;
+	uint8_t            *parsed;
+};
 
 struct fgn_library_t {
 	fgn_graph_t *graphs;
 	int32_t      graph_ct;
 	int32_t      graph_cap;
 	fgn_data_t   data;
+
+	// Memory the library owns and hands out strings and arrays from,
+	// this stays nullptr until something like loading, which interns
+	// keys here, or fgn_lib_use_arena needs it. Freed by fgn_destroy.
+	_fgn_mem_t  *mem;
 };
 
 struct fgn_graph_t {
@@ -192,14 +272,78 @@ struct fgn_graph_t {
 	int32_t     edge_ct;
 	int32_t     edge_cap;
 	fgn_data_t  data;
+
+	// Data for the nodes and edges that have any, most edges and plenty
+	// of nodes don't. They refer to it by data_ref, and freed entries are
+	// listed in node_data_free and edge_data_free for reuse.
+	fgn_data_t   *node_data;
+	int32_t       node_data_ct;
+	int32_t       node_data_cap;
+	int32_t      *node_data_free;
+	int32_t       node_data_free_ct;
+	int32_t       node_data_free_cap;
+	fgn_data_t   *edge_data;
+	int32_t       edge_data_ct;
+	int32_t       edge_data_cap;
+	int32_t      *edge_data_free;
+	int32_t       edge_data_free_ct;
+	int32_t       edge_data_free_cap;
+
+	// Open addressing hash table of node_idx+1 keyed by node id_hash,
+	// 0 marks an empty slot. Kept up to date by the graph functions.
+	fgn_node_idx *node_index;
+	int32_t       node_index_cap;
+
+	// The owning library's memory, ids and data may point into it
+	_fgn_mem_t   *mem;
+
+	// Slot maps behind fgn_handle_t, nullptr until fgn_graph_use_handles
+	_fgn_slots_t *node_slots;
+	_fgn_slots_t *edge_slots;
+
+	// Hot node columns, indexed like nodes and always sized with them.
+	// Passes over hashes, positions or edge counts stay in these small
+	// arrays instead of striding over whole fgn_node_ts.
+	fgn_hash_t   *node_hashes;
+	float        *node_positions; // 3 floats per node
+	int32_t      *node_in_cts;
+	int32_t      *node_out_cts;
+	int32_t       node_column_cap;
+
+	// Parsed structs for every node and every edge, each in one array
+	// indexed like nodes and edges. Set up by fgn_parse, fgn_parse_lazy
+	// or the first fgn_graph_node_data/fgn_graph_edge_data, the nodes'
+	// and edges' own data.data stays nullptr once these are in use.
+	_fgn_structs_t node_structs;
+	_fgn_structs_t edge_structs;
 };
 
-int32_t fgn_load     (fgn_library_t &lib, const char *filedata);
-int32_t fgn_load_file(fgn_library_t &lib, const char *filename);
+// The load functions can split the work across thread_ct threads, one
+// graph section at a time, 0 will use every hardware thread. The result
+// is the same as loading on a single thread.
+int32_t fgn_load     (fgn_library_t &lib, const char *filedata, int32_t thread_ct = 1);
+int32_t fgn_load_file(fgn_library_t &lib, const char *filename, int32_t thread_ct = 1);
+// Maps the file into memory instead of reading it, and has ids, keys
+// and values point directly into the mapping rather than copying each
+// of them. The mapping belongs to the library until fgn_destroy. Since
+// everything loaded points into it, a file with errors in it keeps
+// nothing, unlike fgn_load_file, and the mapping is released.
+int32_t fgn_load_file_mapped(fgn_library_t &lib, const char *filename, int32_t thread_ct = 1);
 char   *fgn_save     (fgn_library_t &lib, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
 char   *fgn_save     (fgn_graph_t &graph, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
 int32_t fgn_save_file(fgn_library_t &lib, const char *filename, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
 int32_t fgn_save_file(fgn_graph_t &graph, const char *filename, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
+// A binary sibling of the text format (.fgnb) for fast loading. It has a
+// single deduplicated table of strings, flat node and edge arrays, and
+// compressed in/out adjacency lists. Loading maps the file, and points
+// ids, pairs and adjacency lists straight into it, so the library owns
+// the mapping until fgn_destroy. Files are little-endian. Saving returns
+// 1 if the file couldn't be opened, and 2 if any of it failed to write.
+// Loading returns 1 if the file couldn't be opened, 2 if it isn't a .fgnb
+// file of this version, and 3 if it's truncated or corrupt. Any of these
+// leave the library as it was.
+int32_t fgn_save_binary(fgn_library_t &lib, const char *filename, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
+int32_t fgn_load_binary(fgn_library_t &lib, const char *filename);
 void    fgn_destroy  (fgn_library_t &lib);
 void    fgn_destroy  (fgn_graph_t &graph);
 
@@ -207,6 +351,28 @@ void    fgn_destroy  (fgn_graph_t &graph);
 /// Library functions                   ///
 ///////////////////////////////////////////
 
+// Switches an empty library over to arena allocation: ids, pairs,
+// adjacency lists and parsed structs for everything loaded or added
+// afterwards come out of large chunks owned by the library. Edits still
+// work, but memory is only given back when the whole library is
+// destroyed, which then costs about as much as freeing the chunks.
+void                fgn_lib_use_arena(fgn_library_t &lib);
+// Opt-in for an empty library: values loaded afterwards, or added to the
+// library and its graphs, nodes and edges, are kept once per distinct
+// string in library memory, and shared by every pair that has them. Pair
+// lists then live there as well, like arena mode, and fgn_data_set_value
+// swaps in a new string rather than touching a shared one. Mapped loads
+// copy shared values out of the file. Parallel loads keep a dictionary
+// per thread while loading, and then point every value at the library's
+// copy, so the first copy a thread made of each string stays around too.
+void                fgn_lib_share_values(fgn_library_t &lib);
+struct fgn_value_stats_t {
+	int64_t value_ct;     // Values on every pair in the library
+	int64_t unique_ct;    // Distinct strings those values point at
+	int64_t value_bytes;  // Bytes the values would take if none were shared
+	int64_t stored_bytes; // Bytes the distinct strings actually take
+};
+fgn_value_stats_t   fgn_lib_value_stats (const fgn_library_t &lib);
 fgn_graph_idx       fgn_lib_add   (      fgn_library_t &lib, const char   *graph_id);
 fgn_graph_idx       fgn_lib_findid(const fgn_library_t &lib, const char   *graph_id);
 inline int32_t      fgn_lib_count (const fgn_library_t &lib)                          { return lib.graph_ct; }
@@ -219,55 +385,184 @@ void                fgn_lib_delete(      fgn_library_t &lib, fgn_graph_idx graph
 /// Graph manipulation, Nodes and Edges ///
 ///////////////////////////////////////////
 
+// The id hash, position and edge counts of a node live in the graph's
+// node columns, see fgn_graph_node_hash and friends, and its pairs with
+// fgn_graph_node_pairs.
 struct fgn_node_t {
 	char         *id;
-	fgn_hash_t    id_hash;
-	float         position[3];
 
+	// While a node has only a few edges, these point at _in_inline and
+	// _out_inline (cap is 0 then), so nodes shouldn't be copied around
+	// by value. The graph functions keep them pointed at the right spot.
 	fgn_edge_idx *in_edges;
-	int32_t       in_ct, in_cap;
 	fgn_edge_idx *out_edges;
-	int32_t       out_ct, out_cap;
-	fgn_data_t    data;
+	int32_t       in_cap;
+	int32_t       out_cap;
+	// Index+1 into graph.node_data, 0 while the node has no data
+	int32_t       data_ref;
+
+	fgn_edge_idx  _in_inline [_FGN_INLINE_EDGES];
+	fgn_edge_idx  _out_inline[_FGN_INLINE_EDGES];
 };
 struct fgn_edge_t {
 	fgn_node_idx start;
 	fgn_node_idx end;
-	fgn_data_t   data;
+	// Index+1 into graph.edge_data, 0 while the edge has no data
+	int32_t      data_ref;
+};
+struct fgn_handle_t {
+	int32_t  slot;
+	uint32_t generation;
 };
 
 void               fgn_graph_set_id     (fgn_graph_t &graph, const char *id);
 fgn_node_idx       fgn_graph_node_add   (fgn_graph_t &graph, const char *id);
 void               fgn_graph_node_setid (fgn_graph_t &graph, fgn_node_idx idx, const char *text_id);
 fgn_node_idx       fgn_graph_node_findid(const fgn_graph_t &graph, const char *id);
+// Nodes after the deleted one shift down to keep their order, which
+// touches every edge and the whole id index, so each delete is
+// O(edges + nodes). Deleting more than a couple should go through
+// fgn_graph_nodes_delete, or turn on fgn_graph_use_handles to make this
+// only touch the node's own edges.
 void               fgn_graph_node_delete(fgn_graph_t &graph, fgn_node_idx node);
 void               fgn_graph_node_delete(fgn_graph_t &graph, const char *node);
+// Deletes a batch of nodes and their edges in one pass over the graph.
+// Remaining nodes and edges keep their order. Remap arrays are optional,
+// they need room for the old node/edge counts, and get each old index's
+// new index, or -1 if it was deleted.
+void               fgn_graph_nodes_delete(fgn_graph_t &graph, const fgn_node_idx *nodes, int32_t count, fgn_node_idx *out_node_remap = nullptr, fgn_edge_idx *out_edge_remap = nullptr);
 inline fgn_node_t *fgn_graph_node_find  (const fgn_graph_t &graph, const char *id)   { fgn_node_idx i = fgn_graph_node_findid(graph, id); return i == -1 ? nullptr : &graph.nodes[i]; }
 inline int32_t     fgn_graph_node_count (const fgn_graph_t &graph)                   { return graph.node_ct; }
 inline fgn_node_t &fgn_graph_node_get   (const fgn_graph_t &graph, fgn_node_idx idx) { return graph.nodes[idx]; }
+// Nodes keep their key/value pairs off to the side too, the same way
+// edges do below.
+fgn_data_t        &fgn_graph_node_pairs (fgn_graph_t &graph, fgn_node_idx idx);
+inline bool        fgn_graph_node_has_data  (const fgn_graph_t &graph, fgn_node_idx idx) { return graph.nodes[idx].data_ref != 0; }
+inline int32_t     fgn_graph_node_pair_count(const fgn_graph_t &graph, fgn_node_idx idx) { return graph.nodes[idx].data_ref != 0 ? graph.node_data[graph.nodes[idx].data_ref - 1].pair_ct : 0; }
 inline void        fgn_graph_node_each  (fgn_graph_t &graph, void (*each)(fgn_graph_t &graph, fgn_node_t &node)) { for (int i = 0, ct = fgn_graph_node_count(graph); i < ct; i += 1) each(graph, fgn_graph_node_get(graph, i)); }
 
 fgn_edge_idx       fgn_graph_edge_add   (fgn_graph_t &graph, fgn_node_idx start, fgn_node_idx end);
 fgn_edge_idx       fgn_graph_edge_add   (fgn_graph_t &graph, const char *start, const char *end);
-void               fgn_graph_edge_delete(fgn_graph_t &graph, fgn_edge_idx edge);
+// Edge deletion moves the last edge into the deleted slot, and returns
+// the index that edge used to have, or -1 if the last edge was deleted.
+fgn_edge_idx       fgn_graph_edge_delete(fgn_graph_t &graph, fgn_edge_idx edge);
+void               fgn_graph_edges_delete(fgn_graph_t &graph, const fgn_edge_idx *edges, int32_t count, fgn_edge_idx *out_edge_remap = nullptr);
+// Edges keep their key/value pairs off to the side, since most have
+// none. This gets an edge's, making an empty set the first time it's
+// asked for. Getting a new one can move the others, so don't hold on
+// to the reference across edits.
+fgn_data_t        &fgn_graph_edge_pairs (fgn_graph_t &graph, fgn_edge_idx idx);
+inline bool        fgn_graph_edge_has_data  (const fgn_graph_t &graph, fgn_edge_idx idx) { return graph.edges[idx].data_ref != 0; }
+inline int32_t     fgn_graph_edge_pair_count(const fgn_graph_t &graph, fgn_edge_idx idx) { return graph.edges[idx].data_ref != 0 ? graph.edge_data[graph.edges[idx].data_ref - 1].pair_ct : 0; }
+
+// Handles stay valid through any edit until their node or edge is
+// deleted, and resolve to -1 afterwards. Turning them on also makes
+// fgn_graph_node_delete move the last node into the gap like edges do,
+// so deletes only touch the node's own edges. Nodes and edges stay
+// densely packed, so loops over indices work as usual. Using these on
+// a graph without handles asserts, or in release builds gives handles
+// that resolve to -1.
+void               fgn_graph_use_handles   (fgn_graph_t &graph);
+fgn_handle_t       fgn_graph_node_handle   (const fgn_graph_t &graph, fgn_node_idx idx);
+fgn_node_idx       fgn_graph_node_resolve  (const fgn_graph_t &graph, fgn_handle_t handle);
+fgn_handle_t       fgn_graph_edge_handle   (const fgn_graph_t &graph, fgn_edge_idx idx);
+fgn_edge_idx       fgn_graph_edge_resolve  (const fgn_graph_t &graph, fgn_handle_t handle);
+
+// Node columns, the edge lists these count are node.in_edges and
+// node.out_edges.
+inline float      *fgn_graph_node_position (const fgn_graph_t &graph, fgn_node_idx idx) { return &graph.node_positions[idx * 3]; }
+inline fgn_hash_t  fgn_graph_node_hash     (const fgn_graph_t &graph, fgn_node_idx idx) { return graph.node_hashes [idx]; }
+inline int32_t     fgn_graph_node_in_count (const fgn_graph_t &graph, fgn_node_idx idx) { return graph.node_in_cts [idx]; }
+inline int32_t     fgn_graph_node_out_count(const fgn_graph_t &graph, fgn_node_idx idx) { return graph.node_out_cts[idx]; }
 inline int32_t     fgn_graph_edge_count (const fgn_graph_t &graph)                   { return graph.edge_ct; }
 inline fgn_edge_t &fgn_graph_edge_get   (const fgn_graph_t &graph, fgn_edge_idx idx) { return graph.edges[idx]; }
 inline void        fgn_graph_edge_each  (fgn_graph_t &graph, void (*each)(fgn_graph_t &graph, fgn_edge_t &edge)) { for (int i = 0, ct = fgn_graph_edge_count(graph); i < ct; i += 1) each(graph, fgn_graph_edge_get(graph, i)); }
 
+///////////////////////////////////////////
+/// Frozen graphs                       ///
+///////////////////////////////////////////
+
+// Compressed sparse row copy of a graph's adjacency, for traversals that
+// don't edit. Node n's outgoing neighbors are out_nodes[out_start[n]]
+// up to out_nodes[out_start[n+1]], with the edge that leads there in the
+// same spot of out_edges, in the same order as the node's out_edges
+// list. The in_ arrays are the same for incoming edges. It's a snapshot,
+// edits to the graph won't show up until fgn_graph_freeze is called on
+// it again, which reuses its memory when it can.
+struct fgn_frozen_t {
+	int32_t       node_ct;
+	int32_t       edge_ct;
+	int32_t      *out_start;
+	fgn_node_idx *out_nodes;
+	fgn_edge_idx *out_edges;
+	int32_t      *in_start;
+	fgn_node_idx *in_nodes;
+	fgn_edge_idx *in_edges;
+
+	// All the arrays above share this one allocation
+	int32_t      *mem;
+	size_t        mem_cap;
+};
+
+void                       fgn_graph_freeze    (const fgn_graph_t &graph, fgn_frozen_t &frozen);
+void                       fgn_destroy         (fgn_frozen_t &frozen);
+inline int32_t             fgn_frozen_out_count(const fgn_frozen_t &frozen, fgn_node_idx idx) { return frozen.out_start[idx + 1] - frozen.out_start[idx]; }
+inline int32_t             fgn_frozen_in_count (const fgn_frozen_t &frozen, fgn_node_idx idx) { return frozen.in_start [idx + 1] - frozen.in_start [idx]; }
+inline const fgn_node_idx *fgn_frozen_out      (const fgn_frozen_t &frozen, fgn_node_idx idx) { return &frozen.out_nodes[frozen.out_start[idx]]; }
+inline const fgn_node_idx *fgn_frozen_in       (const fgn_frozen_t &frozen, fgn_node_idx idx) { return &frozen.in_nodes [frozen.in_start [idx]]; }
+
 ///////////////////////////////////////////
 
+void *_fgn_data_alloc(fgn_data_t &data, size_t size);
 template<typename T> T &fgn_data_get       (fgn_data_t &data) {
-	if (data.data == nullptr) {
-		data.data = malloc(sizeof(T));
-		memset(data.data, 0, sizeof(T));
-	}
+	if (data.data == nullptr)
+		data.data = _fgn_data_alloc(data, sizeof(T));
 	return *(T*)data.data;
 }
-template<typename T> T &fgn_graph_node_data(const fgn_graph_t &graph, fgn_node_idx idx) { assert(idx >= 0 && idx < graph.node_ct); return fgn_data_get<T>(graph.nodes[idx].data); }
-template<typename T> T &fgn_graph_edge_data(const fgn_graph_t &graph, fgn_edge_idx idx) { assert(idx >= 0 && idx < graph.edge_ct); return fgn_data_get<T>(graph.edges[idx].data); }
+bool  _fgn_structs_use(fgn_graph_t &graph, bool edges, int32_t size, bool clear);
+void  _fgn_structs_parse(fgn_graph_t &graph, bool edges, int32_t idx);
+void  _fgn_structs_parse_all(fgn_graph_t &graph, bool edges);
+inline void *_fgn_graph_struct(fgn_graph_t &graph, bool edges, int32_t idx, int32_t size) {
+	_fgn_structs_t &structs = edges ? graph.edge_structs : graph.node_structs;
+	if (structs.size != size && !_fgn_structs_use(graph, edges, size, false))
+		return nullptr;
+	if (structs.parsed != nullptr && !structs.parsed[idx])
+		_fgn_structs_parse(graph, edges, idx);
+	return structs.data + (size_t)idx * size;
+}
+// A graph's nodes all share one struct type, as do its edges. Asking
+// for a struct of a different size leaves the existing ones alone, and
+// the pointer versions return nullptr for it, the reference ones assert.
+template<typename T> T &fgn_graph_node_data(fgn_graph_t &graph, fgn_node_idx idx) { assert(idx >= 0 && idx < graph.node_ct); T *result = (T *)_fgn_graph_struct(graph, false, idx, sizeof(T)); assert(result != nullptr); return *result; }
+template<typename T> T &fgn_graph_edge_data(fgn_graph_t &graph, fgn_edge_idx idx) { assert(idx >= 0 && idx < graph.edge_ct); T *result = (T *)_fgn_graph_struct(graph, true,  idx, sizeof(T)); assert(result != nullptr); return *result; }
+template<typename T> T *fgn_graph_node_data(fgn_graph_t &graph, const char *id) { fgn_node_idx i = fgn_graph_node_findid(graph, id); return i == -1 ? nullptr : (T *)_fgn_graph_struct(graph, false, i, sizeof(T)); }
+// Const graphs can't set up or lazily parse structs, so these only hand
+// back ones that are already there, and assert if they aren't.
+template<typename T> T &fgn_graph_node_data(const fgn_graph_t &graph, fgn_node_idx idx) { const _fgn_structs_t &s = graph.node_structs; assert(idx >= 0 && idx < graph.node_ct && s.size == sizeof(T) && (s.parsed == nullptr || s.parsed[idx])); return *(T *)(s.data + (size_t)idx * sizeof(T)); }
+template<typename T> T &fgn_graph_edge_data(const fgn_graph_t &graph, fgn_edge_idx idx) { const _fgn_structs_t &s = graph.edge_structs; assert(idx >= 0 && idx < graph.edge_ct && s.size == sizeof(T) && (s.parsed == nullptr || s.parsed[idx])); return *(T *)(s.data + (size_t)idx * sizeof(T)); }
 template<typename T> T *fgn_graph_node_data(const fgn_graph_t &graph, const char *id) { fgn_node_idx i = fgn_graph_node_findid(graph, id); return i == -1 ? nullptr : &fgn_graph_node_data<T>(graph, i); }
+// Every node's or edge's struct in one array, indexed like the nodes or
+// edges, for passes over a single field. Adding or removing nodes or
+// edges can move it. Lazily parsed graphs parse everything first.
+template<typename T> T *fgn_graph_node_data_array(fgn_graph_t &graph) { if (_fgn_graph_struct(graph, false, 0, sizeof(T)) == nullptr) return nullptr; _fgn_structs_parse_all(graph, false); return (T *)graph.node_structs.data; }
+template<typename T> T *fgn_graph_edge_data_array(fgn_graph_t &graph) { if (_fgn_graph_struct(graph, true,  0, sizeof(T)) == nullptr) return nullptr; _fgn_structs_parse_all(graph, true ); return (T *)graph.edge_structs.data; }
 
 void                    fgn_data_add    (fgn_data_t &data, const char *key, const char *value);
+// Points a pair at a copy of value. Values in library memory may be
+// shared with other pairs, so they're never written to or freed here.
+void                    fgn_data_set_value(fgn_data_t &data, int32_t pair_idx, const char *value);
+// Key lookups find the first pair with that key. A hash from fgn_hash
+// can be passed along with the key, to skip hashing it every lookup.
+fgn_hash_t              fgn_hash        (const char *key);
+int32_t                 fgn_data_find   (fgn_data_t &data, const char *key);
+int32_t                 fgn_data_find_hash(fgn_data_t &data, const char *key, fgn_hash_t key_hash);
+const char             *fgn_data_value  (fgn_data_t &data, const char *key);
+// Changes the value for key, or adds the pair if it isn't there yet
+void                    fgn_data_set    (fgn_data_t &data, const char *key, const char *value);
+// Removes the pair for key, the remaining pairs keep their order
+bool                    fgn_data_remove (fgn_data_t &data, const char *key);
+// Only for data you made yourself, data on a library's graphs can share
+// strings with the library, and gets cleaned up by fgn_destroy.
 void                    fgn_data_destroy(fgn_data_t &data);
 
 ///////////////////////////////////////////
@@ -279,40 +574,264 @@ struct fgn_parser_t {
 	_fgn_parse_item_t *items;
 	int32_t            item_ct;
 	int32_t            item_cap;
+
+	// Open addressing table of item_idx+1 keyed by item key_hash, 0 marks
+	// an empty slot. fgn_parser_add keeps it at most half full.
+	int32_t           *lookup;
+	int32_t            lookup_cap;
+
+	// Parsers made from a field list get a parse function generated for
+	// their struct, which takes over from items and lookup when parsing.
+	// Returns the number of pairs left over.
+	int32_t          (*parse_pairs)(fgn_parse_state_t state, fgn_data_t &data, void *out_struct);
+	// And a write function, which takes over from items on text saves
+	void             (*write_struct)(_fgn_out_t &out, fgn_parse_state_t state, void *in_struct);
 };
 struct fgn_parse_state_t {
 	fgn_graph_t &graph;
 	fgn_node_idx curr_node;
 	fgn_edge_idx curr_edge;
 };
+
+// Parse functions read value_text into out_data, and return false if
+// they couldn't, which leaves the pair as it was.
+typedef bool    (*fgn_parse_fn)(fgn_parse_state_t state, const char *value_text, void *out_data);
+// Write functions put the text for value into out, and return its
+// length, or -1 to leave the pair out. Like snprintf, if the length is
+// more than out_size then out isn't usable, and they get called again
+// with room for it. out doesn't need a terminator.
+typedef int32_t (*fgn_write_fn)(fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+// The older kind of write function, returning a malloc'd string or
+// nullptr. These still work, but cost an allocation per pair on save.
+typedef char   *(*fgn_write_str_fn)(fgn_parse_state_t state, void *value);
+
 struct _fgn_parse_item_t {
-	const char *key;
-	fgn_hash_t  key_hash;
-	int32_t     offset;
-	bool  (*parse)(fgn_parse_state_t state, const char *value_text, void *out_data);
-	char *(*write)(fgn_parse_state_t state, void *value);
+	const char      *key;
+	fgn_hash_t       key_hash;
+	int32_t          offset;
+	fgn_parse_fn     parse;
+	fgn_write_fn     write;
+	fgn_write_str_fn write_str;
 };
 
 template<typename T> inline void fgn_parser_create(fgn_parser_t &parser) { parser.type_size = sizeof(T); }
-void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset,
-	bool  (*parse)(fgn_parse_state_t state, const char *value_text, void *out_data),
-	char *(*write)(fgn_parse_state_t state, void *value));
-void fgn_parse  (fgn_graph_t   &graph, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
-void fgn_parse  (fgn_library_t &lib, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
+void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset, fgn_parse_fn parse, fgn_write_fn     write);
+void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset, fgn_parse_fn parse, fgn_write_str_fn write);
+inline void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset, fgn_parse_fn parse, decltype(nullptr)) { fgn_parser_add(parser, name, offset, parse, (fgn_write_fn)nullptr); }
+// Parsing can split nodes and edges across thread_ct threads, a range
+// at a time from every graph, 0 will use every hardware thread. The
+// result is the same as parsing on a single thread. Parse functions then
+// run concurrently, so they may only write to out_data, and read the
+// graph. All the fgn_parse_ functions below are fine for this.
+void fgn_parse  (fgn_graph_t   &graph, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr, int32_t thread_ct = 1);
+void fgn_parse  (fgn_library_t &lib, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr, int32_t thread_ct = 1);
+// Attaches the parsers instead of parsing everything now, and each node
+// or edge gets parsed the first time fgn_graph_node_data/edge_data asks
+// for it. Ones that never get asked for keep their raw pairs, and save
+// as they were loaded. Graph data still parses right away. The parsers
+// need to stay around for as long as the graphs do, and since access
+// can parse, lazy graphs shouldn't be read from several threads at once.
+// A later fgn_parse with the same struct parses whatever's left, and
+// keeps the structs that were already parsed.
+void fgn_parse_lazy(fgn_graph_t   &graph, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
+void fgn_parse_lazy(fgn_library_t &lib, const fgn_parser_t *parser_node = nullptr, const fgn_parser_t *parser_edge = nullptr, const fgn_parser_t *parser_graph = nullptr);
 void fgn_destroy(fgn_parser_t  &parser);
+int32_t _fgn_parser_find(const fgn_parser_t &parser, fgn_hash_t key_hash);
+
+bool    fgn_parse_float (fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_float (fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+bool    fgn_parse_float2(fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_float2(fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+bool    fgn_parse_float3(fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_float3(fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+bool    fgn_parse_int32 (fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_int32 (fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+bool    fgn_parse_string(fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_string(fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+bool    fgn_parse_nodeid(fgn_parse_state_t state, const char *value_text, void *out_data);
+int32_t fgn_write_nodeid(fgn_parse_state_t state, void *value, char *out, int32_t out_size);
+
+// Frees a pair that got parsed, if data owns it
+void  _fgn_pair_free(const fgn_graph_t &graph, const fgn_data_t &data, int32_t pair_idx);
+// Saving a parsed item is a write function call between these two. The
+// first gives where the value goes and how much room there is, and the
+// second finishes the line off, or calls write again if it didn't fit.
+char *_fgn_out_item_begin(_fgn_out_t &out, size_t key_len, int32_t &room);
+void  _fgn_out_item_end  (_fgn_out_t &out, fgn_parse_state_t state, const char *key, size_t key_len, fgn_write_fn write, void *value, int32_t length, int32_t room);
+
+///////////////////////////////////////////
+/// Parsers from a struct's fields      ///
+///////////////////////////////////////////
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+/* C++17 and up. Fields are listed once, as a constexpr, and make an
+   ordinary fgn_parser_t that works anywhere else a parser does. Parsing
+   with it skips the item table, and compares key hashes against
+   constants, calling each field's parse function directly.
+
+static constexpr auto node_fields = fgn_fields(
+	fgn_field<&node_data_t::slider  >("slider"),
+	fgn_field<&node_data_t::position>("position"),
+	fgn_field<&node_data_t::other, fgn_parse_nodeid, fgn_write_nodeid>("other"));
+
+fgn_parser_t node_parser = {};
+fgn_parser_create<node_fields>(node_parser);
+
+   float, float[2], float[3], int32_t and strings pick their parse and
+   write functions, anything else (including node ids) names them. The
+   struct needs to be standard-layout. Text saves get a generated writer
+   too, which calls each field's write function directly, binary saves
+   go through the items like they do for any parser. */
+
+template<typename T> struct _fgn_member;
+template<typename S, typename F> struct _fgn_member<F S::*> { typedef S struct_t; typedef F field_t; };
+
+template<typename F> struct _fgn_field_io;
+template<> struct _fgn_field_io<float      > { static constexpr fgn_parse_fn parse = fgn_parse_float;  static constexpr fgn_write_fn write = fgn_write_float;  };
+template<> struct _fgn_field_io<float[2]   > { static constexpr fgn_parse_fn parse = fgn_parse_float2; static constexpr fgn_write_fn write = fgn_write_float2; };
+template<> struct _fgn_field_io<float[3]   > { static constexpr fgn_parse_fn parse = fgn_parse_float3; static constexpr fgn_write_fn write = fgn_write_float3; };
+template<> struct _fgn_field_io<int32_t    > { static constexpr fgn_parse_fn parse = fgn_parse_int32;  static constexpr fgn_write_fn write = fgn_write_int32;  };
+template<> struct _fgn_field_io<char *     > { static constexpr fgn_parse_fn parse = fgn_parse_string; static constexpr fgn_write_fn write = fgn_write_string; };
+template<> struct _fgn_field_io<const char*> { static constexpr fgn_parse_fn parse = fgn_parse_string; static constexpr fgn_write_fn write = fgn_write_string; };
+
+// Same FNV-1a as fgn_hash, but usable at compile time
+constexpr fgn_hash_t _fgn_hash_const(const char *key, fgn_hash_t hash = 14695981039346656037ULL) {
+	return *key == '\0' ? hash : _fgn_hash_const(key + 1, (hash ^ (uint8_t)*key) * 1099511628211ULL);
+}
+constexpr size_t _fgn_strlen_const(const char *key) {
+	return *key == '\0' ? 0 : 1 + _fgn_strlen_const(key + 1);
+}
+
+template<auto Member, fgn_parse_fn Parse, fgn_write_fn Write> struct _fgn_field_t {
+	typedef typename _fgn_member<decltype(Member)>::struct_t struct_t;
+	const char *key;
+	fgn_hash_t  key_hash;
+	size_t      key_len;
+};
+template<auto Member,
+	fgn_parse_fn Parse = _fgn_field_io<typename _fgn_member<decltype(Member)>::field_t>::parse,
+	fgn_write_fn Write = _fgn_field_io<typename _fgn_member<decltype(Member)>::field_t>::write>
+constexpr _fgn_field_t<Member, Parse, Write> fgn_field(const char *key) { return { key, _fgn_hash_const(key), _fgn_strlen_const(key) }; }
+template<typename... Fields>
+constexpr std::tuple<Fields...> fgn_fields(Fields... fields) { return std::tuple<Fields...>(fields...); }
+
+template<auto Member, fgn_parse_fn Parse, fgn_write_fn Write>
+bool _fgn_field_parse(const _fgn_field_t<Member, Parse, Write> &, fgn_parse_state_t state, const char *value, void *out_struct) {
+	return Parse(state, value, &(((typename _fgn_member<decltype(Member)>::struct_t *)out_struct)->*Member));
+}
+template<auto Member, fgn_parse_fn Parse, fgn_write_fn Write>
+void _fgn_field_write(const _fgn_field_t<Member, Parse, Write> &field, _fgn_out_t &out, fgn_parse_state_t state, void *in_struct) {
+	if constexpr (Write == nullptr) return;
+	void   *value = &(((typename _fgn_member<decltype(Member)>::struct_t *)in_struct)->*Member);
+	int32_t room;
+	char   *at     = _fgn_out_item_begin(out, field.key_len, room);
+	int32_t length = Write(state, value, at, room);
+	_fgn_out_item_end(out, state, field.key, field.key_len, Write, value, length, room);
+}
+template<auto Member, fgn_parse_fn Parse, fgn_write_fn Write>
+void _fgn_field_add(fgn_parser_t &parser, const _fgn_field_t<Member, Parse, Write> &field) {
+	typedef typename _fgn_member<decltype(Member)>::struct_t struct_t;
+	static_assert(std::is_standard_layout<struct_t>::value, "fgn_fields: the struct needs to be standard-layout");
+	// The member's offset, measured on a real struct
+	struct_t at = {};
+	fgn_parser_add(parser, field.key, (int32_t)((const uint8_t *)&(at.*Member) - (const uint8_t *)&at), Parse, Write);
+}
+
+// A table from key hash to field, worked out at compile time. Some run
+// of the hash's bits picks a slot, and the shift is searched for one
+// where every field lands in a slot of its own. Slots hold field_idx+1,
+// and duplicate keys keep the first field, like fgn_parser_t.
+constexpr int32_t _fgn_fields_cap(size_t field_ct) {
+	int32_t cap = 8;
+	while ((size_t)cap < field_ct * field_ct)
+		cap *= 2;
+	return cap;
+}
+template<size_t N> struct _fgn_fields_table_t {
+	static constexpr int32_t cap = _fgn_fields_cap(N);
+	fgn_hash_t hashes[N];
+	int32_t    shift; // 64 if no shift worked
+	uint16_t   slots[cap];
+};
+template<size_t N>
+constexpr _fgn_fields_table_t<N> _fgn_fields_table(const fgn_hash_t (&hashes)[N]) {
+	typedef _fgn_fields_table_t<N> table_t;
+	table_t result = {};
+	for (size_t i = 0; i < N; i++)
+		result.hashes[i] = hashes[i];
+	for (result.shift = 0; result.shift < 64; result.shift++) {
+		size_t i = 0;
+		for (; i < N; i++) {
+			int32_t slot = (int32_t)((hashes[i] >> result.shift) & (table_t::cap - 1));
+			if      (result.slots[slot] == 0)                           result.slots[slot] = (uint16_t)(i + 1);
+			else if (result.hashes[result.slots[slot] - 1] != hashes[i]) break;
+		}
+		if (i == N) break;
+		// Collision, clear out what this shift filled in
+		for (size_t c = 0; c < i; c++)
+			result.slots[(hashes[c] >> result.shift) & (table_t::cap - 1)] = 0;
+	}
+	return result;
+}
+template<const auto &Fields, size_t... I>
+constexpr auto _fgn_fields_table(std::index_sequence<I...>) {
+	const fgn_hash_t hashes[] = { std::get<I>(Fields).key_hash... };
+	return _fgn_fields_table(hashes);
+}
 
-bool  fgn_parse_float (fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_float (fgn_parse_state_t state, void *value);
-bool  fgn_parse_float2(fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_float2(fgn_parse_state_t state, void *value);
-bool  fgn_parse_float3(fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_float3(fgn_parse_state_t state, void *value);
-bool  fgn_parse_int32 (fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_int32 (fgn_parse_state_t state, void *value);
-bool  fgn_parse_string(fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_string(fgn_parse_state_t state, void *value);
-bool  fgn_parse_nodeid(fgn_parse_state_t state, const char *value_text, void *out_data);
-char *fgn_write_nodeid(fgn_parse_state_t state, void *value);
+// The table turns a pair's key into a field index, and that switches
+// straight to the field's parse function.
+template<const auto &Fields, size_t... I>
+bool _fgn_fields_parse_pair(fgn_parse_state_t state, fgn_hash_t key_hash, const char *value, void *out_struct, std::index_sequence<I...> seq) {
+	static constexpr auto table = _fgn_fields_table<Fields>(seq);
+	static_assert(table.shift < 64, "fgn_fields: couldn't fit the field hashes into a table");
+	int32_t field = table.slots[(key_hash >> table.shift) & (table.cap - 1)] - 1;
+	if (field == -1 || table.hashes[field] != key_hash)
+		return false;
+	bool result = false;
+	(void)((field == (int32_t)I && (result = _fgn_field_parse(std::get<I>(Fields), state, value, out_struct), true)) || ...);
+	return result;
+}
+template<const auto &Fields>
+int32_t _fgn_fields_parse(fgn_parse_state_t state, fgn_data_t &data, void *out_struct) {
+	constexpr size_t field_ct = std::tuple_size<typename std::decay<decltype(Fields)>::type>::value;
+	int32_t ct = 0;
+	for (int32_t i = 0; i < data.pair_ct; i++) {
+		if (_fgn_fields_parse_pair<Fields>(state, data.pairs[i].key_hash, data.pairs[i].value, out_struct, std::make_index_sequence<field_ct>{})) {
+			if (data.pair_cap > 0)
+				_fgn_pair_free(state.graph, data, i);
+			continue;
+		}
+		data.pairs[ct++] = data.pairs[i];
+	}
+	return ct;
+}
+// Saves write every field in order, same as the items would
+template<const auto &Fields, size_t... I>
+void _fgn_fields_write(_fgn_out_t &out, fgn_parse_state_t state, void *in_struct, std::index_sequence<I...>) {
+	(_fgn_field_write(std::get<I>(Fields), out, state, in_struct), ...);
+}
+template<const auto &Fields>
+void _fgn_fields_write(_fgn_out_t &out, fgn_parse_state_t state, void *in_struct) {
+	_fgn_fields_write<Fields>(out, state, in_struct, std::make_index_sequence<std::tuple_size<typename std::decay<decltype(Fields)>::type>::value>{});
+}
+template<const auto &Fields, size_t... I>
+void _fgn_fields_create(fgn_parser_t &parser, std::index_sequence<I...>) {
+	typedef typename std::tuple_element<0, typename std::decay<decltype(Fields)>::type>::type::struct_t struct_t;
+	static_assert((std::is_same<struct_t, typename std::tuple_element<I, typename std::decay<decltype(Fields)>::type>::type::struct_t>::value && ...), "fgn_fields: every field needs to be from the same struct");
+	parser.type_size = sizeof(struct_t);
+	(_fgn_field_add(parser, std::get<I>(Fields)), ...);
+	parser.parse_pairs  = _fgn_fields_parse<Fields>;
+	parser.write_struct = _fgn_fields_write<Fields>;
+}
+template<const auto &Fields> void fgn_parser_create(fgn_parser_t &parser) {
+	_fgn_fields_create<Fields>(parser, std::make_index_sequence<std::tuple_size<typename std::decay<decltype(Fields)>::type>::value>{});
+}
+#endif
 
 /* /////////////////////////////////////////// **
 ** //////////// Implementation! ////////////// **
@@ -321,7 +840,53 @@ char *fgn_write_nodeid(fgn_parse_state_t state, void *value);
 #ifdef FERR_GRAPHNET_IMPLEMENT
 
 #include <stdio.h>
-#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+#include <atomic>
+#include <thread>
+
+#if !defined(FERR_GRAPHNET_NO_SIMD) && defined(__AVX2__)
+#define _FGN_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(FERR_GRAPHNET_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define _FGN_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// The SIMD scanner reads whole aligned blocks, which can run past the
+// end of a string, but never past the end of the page it's on, or past
+// the range it was given.
+#if defined(__clang__) || defined(__GNUC__)
+#define _FGN_NO_SANITIZE __attribute__((no_sanitize("address")))
+#else
+#define _FGN_NO_SANITIZE
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+#define _FGN_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define _FGN_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+#else
+#define _FGN_PREFETCH(ptr)
+#endif
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 ///////////////////////////////////////////
 /// Private helper functions            ///
@@ -329,130 +894,407 @@ char *fgn_write_nodeid(fgn_parse_state_t state, void *value);
 
 // String utilities
 bool        _fgn_str_eq      (const char *a, const char *b);
-bool        _fgn_str_starts  (const char *a, const char *b);
 fgn_hash_t  _fgn_str_hash    (const char *string);
+fgn_hash_t  _fgn_str_hash_n  (const char *string, size_t length);
 char       *_fgn_str_copy    (const char *string);
-void        _fgn_str_append  (char **string, int32_t &count, int32_t &cap, const char *text, ...);
-char       *_fgn_str_make    (const char *text, ...);
-char       *_fgn_str_escape  (const char *str);
+char       *_fgn_str_copy_n  (const char *string, size_t length);
 void        _fgn_str_unescape(char *str);
 
+// Number conversion, independent of locale. Floats are written with
+// the fewest digits that still parse back to the exact same bits.
+int32_t     _fgn_float_write (float value, char *out_text);
+float       _fgn_float_parse (const char *text);
+int32_t     _fgn_int_write   (int32_t value, char *out_text);
+int32_t     _fgn_int_parse   (const char *text);
+
+// Output for saving, either a growing string, or a fixed size buffer
+// that gets flushed to a file whenever it fills up.
+struct _fgn_out_t {
+	char  *text;
+	size_t ct;
+	size_t cap;
+	FILE  *fp;
+};
+void        _fgn_out_flush  (_fgn_out_t &out);
+void        _fgn_out_reserve(_fgn_out_t &out, size_t length);
+void        _fgn_out_str    (_fgn_out_t &out, const char *str, size_t length);
+void        _fgn_out_value  (_fgn_out_t &out, const char *str);
+void        _fgn_out_float  (_fgn_out_t &out, float value);
+void        _fgn_out_item   (_fgn_out_t &out, fgn_parse_state_t state, const _fgn_parse_item_t &item, void *value);
+void        _fgn_save_lib   (_fgn_out_t &out, fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph);
+void        _fgn_save_graph (_fgn_out_t &out, fgn_graph_t &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph);
+int32_t     _fgn_save_file  (const char *filename, fgn_library_t *lib, fgn_graph_t *graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph);
+
 // File parsing
 const char *_fgn_str_trim     (const char *str);
-const char *_fgn_str_next_line(const char *str);
 const char *_fgn_str_next_word(const char *str, char sep);
-char       *_fgn_str_copy_line(const char *str);
-char       *_fgn_str_copy_word(const char *str, char sep);
-bool        _fgn_str_line_has (const char *str, char sep);
-bool        _fgn_str_contains (const char *str, char sep);
+
+// Everything the loader needs to know about a line, found in a single
+// quote-aware pass. Separators that don't show up are set to end.
+struct _fgn_line_t {
+	const char *end;        // First '\n', '\r' or '\0' outside of quotes, or range_end
+	const char *space;      // First ' ' outside of quotes
+	const char *colon;      // First ':' outside of quotes
+	const char *comma[2];   // First two ',' outside of quotes
+	const char *last_quote; // Last '"' before end, nullptr if there isn't one
+};
+void        _fgn_scan_line    (const char *str, const char *range_start, const char *range_end, _fgn_line_t &line);
 
 // Array modification
 template<typename T> int32_t _fgn_arr_add(T **arr, int32_t quantity, int32_t &count, int32_t &capacity);
 template<typename T> void    _fgn_arr_remove(T **arr, int32_t index, int32_t &count);
 
+// Node id hash index
+int32_t      _fgn_index_slot  (fgn_hash_t hash, int32_t cap);
+void         _fgn_index_build (fgn_graph_t &graph);
+void         _fgn_index_add   (fgn_graph_t &graph, fgn_node_idx idx);
+void         _fgn_index_remove(fgn_graph_t &graph, fgn_node_idx idx);
+void         _fgn_index_move  (fgn_graph_t &graph, fgn_node_idx from, fgn_node_idx to);
+fgn_node_idx _fgn_index_find  (const fgn_graph_t &graph, fgn_hash_t hash, const char *id, size_t id_len);
+
+// Hot node columns
+void         _fgn_columns_grow  (fgn_graph_t &graph, int32_t count);
+void         _fgn_columns_copy  (fgn_graph_t &graph, fgn_node_idx from, fgn_node_idx to);
+void         _fgn_columns_remove(fgn_graph_t &graph, fgn_node_idx idx);
+
+// Parsed struct arrays, these only get called while structs.data is set
+void         _fgn_structs_grow  (_fgn_structs_t &structs, int32_t count);
+void         _fgn_structs_add   (_fgn_structs_t &structs, int32_t idx);
+void         _fgn_structs_copy  (_fgn_structs_t &structs, int32_t from, int32_t to);
+void         _fgn_structs_remove(_fgn_structs_t &structs, int32_t idx, int32_t count);
+void         _fgn_structs_eager (_fgn_structs_t &structs);
+// The struct a node or edge parsed into, nullptr if it hasn't been yet,
+// in which case its pairs are still all there.
+inline void *_fgn_parsed_node   (const fgn_graph_t &graph, fgn_node_idx idx) { return graph.node_structs.data != nullptr ? (graph.node_structs.parsed == nullptr || graph.node_structs.parsed[idx] ? graph.node_structs.data + (size_t)idx * graph.node_structs.size : nullptr) : graph.nodes[idx].data_ref != 0 ? graph.node_data[graph.nodes[idx].data_ref - 1].data : nullptr; }
+inline void *_fgn_parsed_edge   (const fgn_graph_t &graph, fgn_edge_idx idx) { return graph.edge_structs.data != nullptr ? (graph.edge_structs.parsed == nullptr || graph.edge_structs.parsed[idx] ? graph.edge_structs.data + (size_t)idx * graph.edge_structs.size : nullptr) : graph.edges[idx].data_ref != 0 ? graph.edge_data[graph.edges[idx].data_ref - 1].data : nullptr; }
+
+// Library owned memory
+struct _fgn_interned_t {
+	fgn_hash_t hash;
+	char      *string;
+};
+struct _fgn_mem_region_t {
+	uint8_t *start;
+	size_t   size;
+	size_t   used;
+	bool     mapped;
+};
+struct _fgn_mem_t {
+	_fgn_mem_region_t *regions;
+	int32_t            region_ct;
+	int32_t            region_cap;
+	size_t             chunk_size;
+	bool               arena;
+	bool               share_values; // Intern values too, see fgn_lib_share_values
+
+	// Memory from other threads that was handed over to this one
+	_fgn_mem_t       **children;
+	int32_t            child_ct;
+	int32_t            child_cap;
+
+	// Strings that repeat a lot, like keys, are kept here once and
+	// shared. Open addressing table, power of 2 size, at most half full.
+	// Ids don't go here, they're unique within a graph, and finding one
+	// by text would need a lookup in here that costs the same compare
+	// the node index does once a 64 bit hash matches.
+	_fgn_interned_t   *interned;
+	int32_t            interned_ct;
+	int32_t            interned_cap;
+};
+_fgn_mem_t *_fgn_mem_create  ();
+_fgn_mem_t *_fgn_mem_create_child(_fgn_mem_t *parent);
+void        _fgn_mem_destroy (_fgn_mem_t *mem);
+void        _fgn_mem_region_free(_fgn_mem_region_t &region);
+void       *_fgn_mem_alloc   (_fgn_mem_t *mem, size_t size);
+char       *_fgn_mem_str     (_fgn_mem_t *mem, const char *string);
+char       *_fgn_mem_str_n   (_fgn_mem_t *mem, const char *string, size_t length);
+char       *_fgn_mem_intern  (_fgn_mem_t *mem, const char *string, size_t length, fgn_hash_t hash);
+char       *_fgn_mem_value   (_fgn_mem_t *mem, const char *string);
+bool        _fgn_mem_owns    (const _fgn_mem_t *mem, const void *ptr);
+char       *_fgn_mem_map_file(_fgn_mem_t *mem, const char *filename, size_t *out_size);
+// Unmaps or frees a file from _fgn_mem_map_file, and forgets its region
+void        _fgn_mem_release (_fgn_mem_t *mem, const void *file);
+template<typename T> int32_t _fgn_mem_arr_add  (_fgn_mem_t *mem, T **arr, int32_t quantity, int32_t &count, int32_t &capacity);
+template<typename T> int32_t _fgn_graph_arr_add(const fgn_graph_t &graph, T **arr, int32_t quantity, int32_t &count, int32_t &capacity);
+inline bool                  _fgn_graph_arena  (const fgn_graph_t &graph) { return graph.mem != nullptr && graph.mem->arena; }
+// Pair lists come out of library memory in arena mode, and when values are shared
+inline bool                  _fgn_graph_borrows(const fgn_graph_t &graph) { return graph.mem != nullptr && (graph.mem->arena || graph.mem->share_values); }
+
+// Adding items that already have their strings allocated
+fgn_graph_idx _fgn_lib_add       (fgn_library_t &lib,   char *id);
+// Drops graphs and library pairs added past these counts
+void          _fgn_lib_rollback  (fgn_library_t &lib,   int32_t graph_ct, int32_t pair_ct);
+// Points every value in the graph at mem's shared copy of it
+void          _fgn_graph_share_values(fgn_graph_t &graph, _fgn_mem_t *mem);
+fgn_node_idx  _fgn_graph_node_add(fgn_graph_t   &graph, char *id, fgn_hash_t id_hash);
+void          _fgn_data_add      (fgn_data_t    &data,  _fgn_mem_t *mem, char *key, fgn_hash_t key_hash, char *value);
+inline void   _fgn_data_add      (fgn_data_t    &data,  _fgn_mem_t *mem, char *key, char *value) { _fgn_data_add(data, mem, key, _fgn_str_hash(key), value); }
+void          _fgn_data_destroy  (fgn_data_t    &data,  const _fgn_mem_t *mem);
+void          _fgn_data_borrow   (fgn_data_t    &data,  _fgn_mem_t *mem);
+_fgn_mem_t   *_fgn_data_mem      (const fgn_data_t &data);
+// The head in front of a pair list, see _fgn_pairs_head_t
+inline _fgn_pairs_head_t *_fgn_data_head   (const fgn_data_t &data) { return data.pairs == nullptr ? nullptr : (_fgn_pairs_head_t *)data.pairs - 1; }
+inline _fgn_mem_t        *_fgn_data_key_mem(const fgn_data_t &data) { return data.pairs == nullptr ? nullptr : _fgn_data_head(data)->key_mem; }
+void          _fgn_data_index_build(fgn_data_t  &data);
+void          _fgn_data_index_add  (fgn_data_t  &data,  int32_t pair_idx);
+void          _fgn_data_index_drop (fgn_data_t  &data);
+void          _fgn_destroy       (fgn_node_t    &node,  const _fgn_mem_t *mem);
+void          _fgn_node_relink   (fgn_node_t    &node);
+void          _fgn_node_edge_add (const fgn_graph_t &graph, fgn_edge_idx **list, int32_t &count, int32_t &capacity, fgn_edge_idx *inline_list, fgn_edge_idx edge);
+fgn_data_t   &_fgn_node_data_add (fgn_graph_t   &graph, fgn_node_idx node);
+void          _fgn_node_data_free(fgn_graph_t   &graph, fgn_node_idx node);
+fgn_data_t   &_fgn_edge_data_add (fgn_graph_t   &graph, fgn_edge_idx edge);
+void          _fgn_edge_data_free(fgn_graph_t   &graph, fgn_edge_idx edge);
+
+// Slot maps for handles. Live slots hold a dense index, free slots hold
+// the next free slot, and freeing a slot bumps its generation.
+struct _fgn_slot_t {
+	int32_t  idx;
+	uint32_t generation;
+};
+struct _fgn_slots_t {
+	_fgn_slot_t *slots;
+	int32_t      slot_ct, slot_cap;
+	int32_t     *slot_of; // Slot for each dense index
+	int32_t      slot_of_ct, slot_of_cap;
+	int32_t      free;
+};
+_fgn_slots_t *_fgn_slots_create (int32_t count);
+void          _fgn_slots_destroy(_fgn_slots_t *slots);
+void          _fgn_slots_add    (_fgn_slots_t *slots, int32_t idx);
+void          _fgn_slots_remove (_fgn_slots_t *slots, int32_t idx, int32_t moved_from);
+void          _fgn_slots_compact(_fgn_slots_t *slots, const int32_t *map, int32_t old_ct);
+fgn_handle_t  _fgn_slots_handle (const _fgn_slots_t *slots, int32_t idx);
+int32_t       _fgn_slots_resolve(const _fgn_slots_t *slots, fgn_handle_t handle);
+
+// Drops everything mapped to -1 and moves the rest to their new index,
+// a null node_map leaves the nodes where they are.
+void          _fgn_graph_compact (fgn_graph_t   &graph, const fgn_node_idx *node_map, const fgn_edge_idx *edge_map);
+
 ///////////////////////////////////////////
 
-int32_t fgn_load     (fgn_library_t &lib, const char *filedata) {
+// Turns a piece of loaded text into a string. Normally this is a copy,
+// but for in-place loads the text is terminated right where it sits.
+inline char *_fgn_load_str(const char *start, const char *end, bool in_place, _fgn_mem_t *mem) {
+	if (!in_place)
+		return _fgn_mem_str_n(mem, start, end - start);
+	char *result = (char *)start;
+	result[end - start] = '\0';
+	return result;
+}
+
+int32_t _fgn_load(fgn_library_t &lib, const char *filedata, const char *filedata_end, bool in_place) {
 	enum active_ {
 		active_none,
 		active_graph,
 		active_node,
 		active_edge,
+		active_invalid,
 	};
 
-	int32_t result = 0;
-	const char *curr = filedata;
-	curr = _fgn_str_trim(curr);
+	int32_t     result = 0;
+	_fgn_mem_t *mem      = in_place || (lib.mem != nullptr && lib.mem->arena) ? lib.mem : nullptr;
+	bool        owned    = mem == nullptr; // Are strings individually allocated?
+	bool        share    = lib.mem->share_values;
+	_fgn_mem_t *data_mem = share ? lib.mem : mem; // Where pair lists go
+	const char *curr     = _fgn_str_trim(filedata);
 
 	// Read data now
 	active_     active     = active_none;
 	fgn_graph_t *curr_graph = nullptr;
-	fgn_node_t  *curr_node  = nullptr;
-	fgn_edge_t  *curr_edge  = nullptr;
-	while (*curr != '\0') {
+	fgn_node_idx curr_node  = -1;
+	fgn_edge_idx curr_edge  = -1;
+	while (*curr != '\0' && curr != filedata_end) {
+		// Scan the line before anything gets terminated in-place,
+		// everything on this line lives in [curr, line_end).
+		_fgn_line_t line;
+		_fgn_scan_line(curr, filedata, filedata_end, line);
+		const char *line_end = line.end;
+		const char *next     = *line_end == '\0' ? line_end : line_end + 1;
+
 		if (*curr == '-') {
 			// Parse the first 3 characters and make sure they're right
-			curr++;
-			char type = *curr;
-			curr++;
-			if (*curr != ' ' || *curr != '\t')
+			char        type  = curr[1];
+			const char *start = line_end - curr < 3 ? line_end : curr + 3;
+			if (line_end - curr < 3 || (curr[2] != ' ' && curr[2] != '\t'))
 				result = 1;
-			curr++;
 
 			// Check what type this line is
 			if        (type == 'g') {
 				active = active_graph;
 
-				char *id = _fgn_str_copy_line(curr);
-				fgn_graph_idx graph_idx =  fgn_lib_add(lib, id);
+				fgn_graph_idx graph_idx =  _fgn_lib_add(lib, _fgn_load_str(start, line_end, in_place, mem));
 				curr_graph              = &fgn_lib_get(lib, graph_idx);
-
-				free(id);
+			} else if (curr_graph == nullptr) {
+				active = active_invalid;
+				result = 2;
 			} else if (type == 'n') {
 				active = active_node;
 
-				char *id = nullptr, *type = nullptr;
-				if (_fgn_str_line_has(curr, ':')) {
-					id   = _fgn_str_copy_word(curr, ':');
-					type = _fgn_str_copy_word(_fgn_str_next_word(curr, ':'),':');
-				} else {
-					id   = _fgn_str_copy_line(curr);
-				}
-				curr_node = &fgn_graph_node_get(*curr_graph, fgn_graph_node_add(*curr_graph, id));
-
-				free(id);
-				free(type);
+				// Anything after a ':' is the node's type, which we don't use yet
+				const char *id_end = line.colon;
+				curr_node = _fgn_graph_node_add(*curr_graph, 
+					_fgn_load_str(start, id_end, in_place, mem), 
+					_fgn_str_hash_n(start, id_end - start));
 			} else if (type == 'e') {
 				active = active_edge;
 
-				const char *end  = _fgn_str_next_word(curr, ',');
-				char *start_copy = _fgn_str_copy_word(curr, ',');
-				char *end_copy   = _fgn_str_copy_word(end,  ',');
-				curr_edge = &fgn_graph_edge_get( *curr_graph, fgn_graph_edge_add(*curr_graph, 
-					fgn_graph_node_findid(*curr_graph, start_copy), 
-					fgn_graph_node_findid(*curr_graph, end_copy)));
-
-				free(start_copy);
-				free(end_copy);
+				const char *start_end = line.comma[0];
+				const char *end       = start_end < line_end ? _fgn_str_trim(start_end + 1) : line_end;
+				if (end > line_end) end = line_end;
+				const char *end_end   = line.comma[1];
+				curr_edge = fgn_graph_edge_add(*curr_graph, 
+					_fgn_index_find(*curr_graph, _fgn_str_hash_n(start, start_end - start), start, start_end - start), 
+					_fgn_index_find(*curr_graph, _fgn_str_hash_n(end,   end_end   - end  ), end,   end_end   - end  ));
 			} else {
 				result = 2;
 			}
 		} else if (*curr == '#') {
 		} else {
 			// Add a kvp to the active item
-			char *key   = _fgn_str_copy_word(curr, ' ');
-			char *value =  _fgn_str_copy_line(_fgn_str_next_word(curr, ' '));
-			_fgn_str_unescape(value);
+			const char *key_end = line.space;
+			const char *val     = key_end < line_end ? _fgn_str_trim(key_end + 1) : line_end;
+			if (val > line_end) val = line_end;
+			bool       is_pos   = active == active_node && key_end - curr == 8 && memcmp(curr, "node_pos", 8) == 0;
+			fgn_hash_t key_hash = _fgn_str_hash_n(curr, key_end - curr);
+			char      *key      = in_place
+				? _fgn_load_str  (curr, key_end, in_place, mem)
+				: _fgn_mem_intern(lib.mem, curr, key_end - curr, key_hash);
+
+			// Only values with quotes in them were escaped. Shared values
+			// get interned after that, so the same text is the same string.
+			bool  escaped = line.last_quote != nullptr && line.last_quote >= val;
+			bool  shared  = share && !is_pos;
+			char *value;
+			if (shared && !escaped) {
+				value = _fgn_mem_intern(lib.mem, val, line_end - val, _fgn_str_hash_n(val, line_end - val));
+			} else if (shared) {
+				char *text = _fgn_str_copy_n(val, line_end - val);
+				_fgn_str_unescape(text);
+				value = _fgn_mem_value(lib.mem, text);
+				free(text);
+			} else {
+				value = _fgn_load_str(val, line_end, in_place, mem);
+				if (escaped) _fgn_str_unescape(value);
+			}
+
+			fgn_data_t *target = nullptr;
 			switch (active) {
-			case active_graph: {
-				if (curr_graph != nullptr)
-					fgn_data_add(curr_graph->data, key, value);
-			}break;
+			case active_graph: target = &curr_graph->data; break;
+			case active_edge:  target = &fgn_graph_edge_pairs(*curr_graph, curr_edge); break;
 			case active_node: {
-				if (curr_node != nullptr) {
-					if (strcmp(key, "node_pos") == 0) // Exception for node position, lets parse that now!
-						fgn_parse_float3(fgn_parse_state_t{ *curr_graph, curr_graph->node_ct, -1 }, value, curr_node->position);
-					else
-						fgn_data_add(curr_node->data, key, value);
+				if (is_pos) { // Exception for node position, lets parse that now!
+					fgn_parse_float3(fgn_parse_state_t{ *curr_graph, curr_graph->node_ct, -1 }, value, fgn_graph_node_position(*curr_graph, curr_graph->node_ct - 1));
+					if (owned) free(value);
+				} else {
+					target = &fgn_graph_node_pairs(*curr_graph, curr_node);
 				}
 			}break;
-			case active_edge: {
-				if (curr_edge != nullptr)
-					fgn_data_add(curr_edge->data, key, value);
+			case active_invalid: {
+				// Keys are interned, so only the value can be ours to free
+				if (owned && !shared) free(value);
 			}break;
-			default: {
-				fgn_data_add(lib.data, key, value);
+			default: target = &lib.data; break;
 			}
+			if (target != nullptr) {
+				// Lists borrowed by an earlier mapped or binary load stay in
+				// their own memory, so heap values move over there first.
+				_fgn_mem_t *target_mem = target->pair_cap < 0 ? _fgn_data_mem(*target) : data_mem;
+				if (target_mem != nullptr && owned && !shared) {
+					char *heap_value = value;
+					value = _fgn_mem_value(target_mem, heap_value);
+					free(heap_value);
+				}
+				_fgn_data_add(*target, target_mem, key, key_hash, value);
+				_fgn_data_head(*target)->key_mem = lib.mem;
 			}
-			free(key);
-			free(value);
 		}
-		curr = _fgn_str_trim(_fgn_str_next_line(curr));
+		curr = _fgn_str_trim(next);
+	}
+
+	return result;
+}
+int32_t _fgn_load_parallel(fgn_library_t &lib, const char *filedata, bool in_place, int32_t thread_ct) {
+	if (thread_ct <= 0)
+		thread_ct = (int32_t)std::thread::hardware_concurrency();
+	if (lib.mem == nullptr)
+		lib.mem = _fgn_mem_create();
+	if (thread_ct <= 1)
+		return _fgn_load(lib, filedata, nullptr, in_place);
+
+	// Quick quote-aware pass to find where each graph section starts.
+	// Sections only ever begin at the start of a line, so each one can be
+	// loaded on its own.
+	const char **sections   = nullptr;
+	int32_t      section_ct = 0, section_cap = 0;
+	_fgn_line_t line;
+	for (const char *curr = _fgn_str_trim(filedata); *curr != '\0'; curr = _fgn_str_trim(line.end)) {
+		_fgn_scan_line(curr, filedata, nullptr, line);
+		if (curr[0] == '-' && curr[1] == 'g') {
+			int32_t i = _fgn_arr_add(&sections, 1, section_ct, section_cap);
+			sections[i] = curr;
+		}
+	}
+	if (section_ct <= 1) {
+		free(sections);
+		return _fgn_load(lib, filedata, nullptr, in_place);
+	}
+	if (thread_ct > section_ct)
+		thread_ct = section_ct;
+
+	// Anything before the first graph belongs to the library itself
+	int32_t result = _fgn_load(lib, filedata, sections[0], in_place);
+
+	// Each thread loads sections into its own library, and grabs the next
+	// section as soon as it's done. Libraries that use their own memory
+	// give each thread its own, which the main library adopts afterwards.
+	struct section_t {
+		fgn_graph_t graph;
+		int32_t     result;
+	};
+	section_t        *loaded  = (section_t     *)calloc(section_ct, sizeof(section_t));
+	fgn_library_t    *workers = (fgn_library_t *)calloc(thread_ct,  sizeof(fgn_library_t));
+	std::thread      *threads = new std::thread[thread_ct];
+	std::atomic<int> next_section(0);
+	for (int32_t t = 0; t < thread_ct; t++) {
+		if (lib.mem != nullptr)
+			workers[t].mem = _fgn_mem_create_child(lib.mem);
+		threads[t] = std::thread([&, t]() {
+			fgn_library_t &worker = workers[t];
+			for (int32_t i = next_section++; i < section_ct; i = next_section++) {
+				const char *end = i + 1 < section_ct ? sections[i + 1] : nullptr;
+				loaded[i].result = _fgn_load(worker, sections[i], end, in_place);
+				loaded[i].graph  = worker.graphs[worker.graph_ct - 1];
+			}
+		});
+	}
+	for (int32_t t = 0; t < thread_ct; t++) {
+		threads[t].join();
+		free(workers[t].graphs);
+	}
+
+	// Splice the graphs into the library in file order. Values each
+	// thread shared only among its own graphs get the library's copy.
+	for (int32_t i = 0; i < section_ct; i++) {
+		fgn_graph_idx idx = _fgn_arr_add(&lib.graphs, 1, lib.graph_ct, lib.graph_cap);
+		lib.graphs[idx]     = loaded[i].graph;
+		lib.graphs[idx].mem = lib.mem;
+		if (lib.mem->share_values)
+			_fgn_graph_share_values(lib.graphs[idx], lib.mem);
+		if (loaded[i].result != 0)
+			result = loaded[i].result;
 	}
 
+	delete [] threads;
+	free(workers);
+	free(loaded);
+	free(sections);
 	return result;
 }
-int32_t fgn_load_file(fgn_library_t &lib, const char *filename) {
+int32_t fgn_load     (fgn_library_t &lib, const char *filedata, int32_t thread_ct) {
+	return _fgn_load_parallel(lib, filedata, false, thread_ct);
+}
+int32_t fgn_load_file(fgn_library_t &lib, const char *filename, int32_t thread_ct) {
 	FILE *fp = nullptr;
 	if (fopen_s(&fp, filename, "rb") != 0 && fp == nullptr)
 		return 1;
@@ -465,395 +1307,1771 @@ int32_t fgn_load_file(fgn_library_t &lib, const char *filename) {
 	filedata[length] = '\0';
 	fclose(fp);
 
-	int32_t result = fgn_load(lib, filedata);
+	int32_t result = fgn_load(lib, filedata, thread_ct);
 
 	free(filedata);
 	return result;
 }
-char   *fgn_save     (fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
-	char *result = nullptr;
-	int32_t ct=0, cap=0;
+int32_t fgn_load_file_mapped(fgn_library_t &lib, const char *filename, int32_t thread_ct) {
+	bool new_mem = lib.mem == nullptr;
+	if (new_mem)
+		lib.mem = _fgn_mem_create();
 
-	// Write the data pairs for the library
-	for (int32_t i = 0; i < lib.data.pair_ct; i++) {
-		char *text = _fgn_str_escape(lib.data.pairs[i].value);
-		_fgn_str_append(&result, ct, cap, "%s %s\n", lib.data.pairs[i].key, text == nullptr ? lib.data.pairs[i].value : text);
-		free(text);
-	}
-	_fgn_str_append(&result, ct, cap, "\n");
+	int32_t graph_ct = lib.graph_ct;
+	int32_t pair_ct  = lib.data.pair_ct;
+	char   *filedata = _fgn_mem_map_file(lib.mem, filename, nullptr);
+	int32_t result   = filedata == nullptr ? 1 : _fgn_load_parallel(lib, filedata, true, thread_ct);
+	if (result == 0)
+		return 0;
 
-	// And append each of the graphs
-	for (int32_t i = 0; i < lib.graph_ct; i++) {
-		char *graph_text = fgn_save(lib.graphs[i], parser_node, parser_edge, parser_graph);
-		_fgn_str_append(&result, ct, cap, graph_text);
-		free(graph_text);
+	// Nothing can keep pointing into the file once it's given back
+	if (filedata != nullptr) {
+		_fgn_lib_rollback(lib, graph_ct, pair_ct);
+		_fgn_mem_release(lib.mem, filedata);
+	}
+	if (new_mem) {
+		if (lib.data.pair_cap < 0)
+			lib.data.pairs = nullptr, lib.data.pair_cap = 0;
+		_fgn_mem_destroy(lib.mem);
+		lib.mem = nullptr;
 	}
-
 	return result;
 }
+char   *fgn_save     (fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	_fgn_out_t out = {};
+	_fgn_save_lib(out, lib, parser_node, parser_edge, parser_graph);
+	_fgn_out_reserve(out, 1);
+	out.text[out.ct] = '\0';
+	return out.text;
+}
 int32_t fgn_save_file(fgn_library_t &lib, const char *filename, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	return _fgn_save_file(filename, &lib, nullptr, parser_node, parser_edge, parser_graph);
+}
+char   *fgn_save     (fgn_graph_t &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	_fgn_out_t out = {};
+	_fgn_save_graph(out, graph, parser_node, parser_edge, parser_graph);
+	_fgn_out_reserve(out, 1);
+	out.text[out.ct] = '\0';
+	return out.text;
+}
+int32_t fgn_save_file(fgn_graph_t &graph, const char *filename, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	return _fgn_save_file(filename, nullptr, &graph, parser_node, parser_edge, parser_graph);
+}
+int32_t _fgn_save_file(const char *filename, fgn_library_t *lib, fgn_graph_t *graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
 	FILE *fp = nullptr;
 	if (fopen_s(&fp, filename, "wb") != 0 && fp == nullptr)
 		return 1;
 
-	char *data = fgn_save(lib, parser_node, parser_edge, parser_graph);
-	fwrite(data, strlen(data), 1, fp);
+	// Stream through a fixed buffer, so memory use doesn't depend on the
+	// size of the library.
+	char       buffer[64 * 1024];
+	_fgn_out_t out = { buffer, 0, sizeof(buffer), fp };
+	if (lib != nullptr) _fgn_save_lib  (out, *lib,   parser_node, parser_edge, parser_graph);
+	else                _fgn_save_graph(out, *graph, parser_node, parser_edge, parser_graph);
+	_fgn_out_flush(out);
+
+	int32_t result = ferror(fp) ? 2 : 0;
 	fclose(fp);
-	free(data);
+	return result;
+}
+void _fgn_save_lib(_fgn_out_t &out, fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	// Write the data pairs for the library
+	for (int32_t i = 0; i < lib.data.pair_ct; i++) {
+		_fgn_out_str  (out, lib.data.pairs[i].key, strlen(lib.data.pairs[i].key));
+		_fgn_out_str  (out, " ", 1);
+		_fgn_out_value(out, lib.data.pairs[i].value);
+		_fgn_out_str  (out, "\n", 1);
+	}
+	_fgn_out_str(out, "\n", 1);
 
-	return 0;
+	// And append each of the graphs
+	for (int32_t i = 0; i < lib.graph_ct; i++)
+		_fgn_save_graph(out, lib.graphs[i], parser_node, parser_edge, parser_graph);
 }
-char   *fgn_save     (fgn_graph_t &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
-	char *result = nullptr;
-	int32_t ct=0, cap=0;
+void _fgn_save_graph(_fgn_out_t &out, fgn_graph_t &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
 	fgn_parse_state_t state = {graph, -1, -1};
 	
-	auto write_data = [&result, &ct, &cap, state](fgn_data_t &data, const fgn_parser_t *parser) {
+	auto write_pair = [&out](const char *key, const char *value) {
+		_fgn_out_str  (out, "\t", 1);
+		_fgn_out_str  (out, key, strlen(key));
+		_fgn_out_str  (out, " ", 1);
+		_fgn_out_value(out, value);
+		_fgn_out_str  (out, "\n", 1);
+	};
+	auto write_data = [&out, &write_pair, &state](const fgn_data_t *data, const fgn_parser_t *parser, void *parsed) {
 		// Write the data we parsed into a struct earlier
-		if (parser != nullptr && data.data != nullptr) {
-			for (size_t i = 0; i < parser->item_ct; i++) {
-				if (parser->items[i].write == nullptr)
-					continue;
-				char *value = parser->items[i].write(state, ((uint8_t *)data.data) + parser->items[i].offset);
-				if (value != nullptr) {
-					char *text = _fgn_str_escape(value);
-					_fgn_str_append(&result, ct, cap, "\t%s %s\n", parser->items[i].key, text == nullptr ? value : text);
+		if (parser != nullptr && parsed != nullptr && parser->write_struct != nullptr) {
+			parser->write_struct(out, state, parsed);
+		} else if (parser != nullptr && parsed != nullptr) {
+			for (int32_t i = 0; i < parser->item_ct; i++) {
+				const _fgn_parse_item_t &item  = parser->items[i];
+				void                    *value = ((uint8_t *)parsed) + item.offset;
+				if (item.write != nullptr) {
+					_fgn_out_item(out, state, item, value);
+				} else if (item.write_str != nullptr) {
+					char *text = item.write_str(state, value);
+					if (text != nullptr)
+						write_pair(item.key, text);
 					free(text);
 				}
-				free(value);
 			}
 		}
 		// Write any key value pairs
-		for (int32_t i = 0; i < data.pair_ct; i++) {
-			char *text = _fgn_str_escape(data.pairs[i].value);
-			_fgn_str_append(&result, ct, cap, "\t%s %s\n", data.pairs[i].key, text == nullptr ? data.pairs[i].value : text);
-			free(text);
-		}
+		for (int32_t i = 0; data != nullptr && i < data->pair_ct; i++)
+			write_pair(data->pairs[i].key, data->pairs[i].value);
 	};
 
-	_fgn_str_append(&result, ct, cap, "-g %s\n", graph.id);
-	write_data(graph.data, parser_graph);
+	_fgn_out_str(out, "-g ", 3);
+	_fgn_out_str(out, graph.id, strlen(graph.id));
+	_fgn_out_str(out, "\n", 1);
+	write_data(&graph.data, parser_graph, graph.data.data);
 
-	_fgn_str_append(&result, ct, cap, "\n");
+	_fgn_out_str(out, "\n", 1);
 	for (int32_t n = 0; n < graph.node_ct; n++) {
-		_fgn_str_append(&result, ct, cap, "-n %s\n", graph.nodes[n].id);
+		_fgn_out_str(out, "-n ", 3);
+		_fgn_out_str(out, graph.nodes[n].id, strlen(graph.nodes[n].id));
+		_fgn_out_str(out, "\n", 1);
 		state.curr_node = n;
 
 		// Exception for position
-		float *pos = graph.nodes[n].position;
-		if (pos[0] != 0 || pos[1] != 0 || pos[2] != 0)
-			_fgn_str_append(&result, ct, cap, "\tnode_pos %g, %g, %g\n", pos[0], pos[1], pos[2]);
+		float *pos = fgn_graph_node_position(graph, n);
+		if (pos[0] != 0 || pos[1] != 0 || pos[2] != 0) {
+			_fgn_out_str  (out, "\tnode_pos ", 10);
+			_fgn_out_float(out, pos[0]);
+			_fgn_out_str  (out, ", ", 2);
+			_fgn_out_float(out, pos[1]);
+			_fgn_out_str  (out, ", ", 2);
+			_fgn_out_float(out, pos[2]);
+			_fgn_out_str  (out, "\n", 1);
+		}
 
-		write_data(graph.nodes[n].data, parser_node);
+		int32_t data_ref = graph.nodes[n].data_ref;
+		write_data(data_ref != 0 ? &graph.node_data[data_ref - 1] : nullptr, parser_node, _fgn_parsed_node(graph, n));
 	}
 	state.curr_node = -1;
 
-	_fgn_str_append(&result, ct, cap, "\n");
+	_fgn_out_str(out, "\n", 1);
 	for (int32_t e = 0; e < graph.edge_ct; e++) {
-		_fgn_str_append(&result, ct, cap, "-e %s, %s\n", graph.nodes[graph.edges[e].start].id, graph.nodes[graph.edges[e].end].id);
+		// Edge ends are scattered around the node list, so fetch the
+		// nodes a little ahead, and then their ids.
+		if (e + 16 < graph.edge_ct) {
+			_FGN_PREFETCH(&graph.nodes[graph.edges[e + 16].start]);
+			_FGN_PREFETCH(&graph.nodes[graph.edges[e + 16].end  ]);
+		}
+		if (e + 8 < graph.edge_ct) {
+			_FGN_PREFETCH(graph.nodes[graph.edges[e + 8].start].id);
+			_FGN_PREFETCH(graph.nodes[graph.edges[e + 8].end  ].id);
+		}
+		const char *start = graph.nodes[graph.edges[e].start].id;
+		const char *end   = graph.nodes[graph.edges[e].end  ].id;
+		_fgn_out_str(out, "-e ", 3);
+		_fgn_out_str(out, start, strlen(start));
+		_fgn_out_str(out, ", ", 2);
+		_fgn_out_str(out, end, strlen(end));
+		_fgn_out_str(out, "\n", 1);
 		state.curr_edge = e;
-		write_data(graph.edges[e].data, parser_edge);
+		int32_t data_ref = graph.edges[e].data_ref;
+		write_data(data_ref != 0 ? &graph.edge_data[data_ref - 1] : nullptr, parser_edge, _fgn_parsed_edge(graph, e));
 	}
-	return result;
 }
-int32_t fgn_save_file(fgn_graph_t &lib, const char *filename, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
-	FILE *fp = nullptr;
-	if (fopen_s(&fp, filename, "wb") != 0 && fp == nullptr)
-		return 1;
+///////////////////////////////////////////
 
-	char *data = fgn_save(lib, parser_node, parser_edge, parser_graph);
-	fwrite(data, strlen(data), 1, fp);
-	fclose(fp);
-	free(data);
+struct _fgnb_header_t {
+	char     magic[4];
+	uint32_t version;
+	uint32_t graph_ct;
+	uint32_t pair_ct;
+	uint64_t string_ct;
+	uint64_t strings_at; // File offset of the string table
+	uint64_t graphs_at;  // File offset of the graph offset table
+};
+struct _fgnb_pair_t {
+	uint32_t key;
+	uint32_t value;
+};
+struct _fgnb_graph_t {
+	uint32_t id;
+	uint32_t pair_ct;
+	uint32_t node_ct;
+	uint32_t edge_ct;
+	uint32_t node_pair_ct;
+	uint32_t edge_pair_ct;
+};
 
-	return 0;
-}
-void    fgn_destroy  (fgn_node_t &node) {
-	free(node.id);
-	free(node.in_edges);
-	free(node.out_edges);
-	fgn_data_destroy(node.data);
-}
-void    fgn_destroy  (fgn_library_t &lib) {
-	fgn_data_destroy(lib.data);
-	for (int32_t i = 0; i < lib.graph_ct; i++) {
-		fgn_destroy(lib.graphs[i]);
+// Builds the deduplicated string table while saving
+struct _fgnb_strings_t {
+	uint32_t   *slots; // Open addressing table of string idx+1
+	int32_t     slot_cap;
+	fgn_hash_t *hashes;
+	uint64_t   *offsets;
+	int32_t     ct, cap, offset_cap;
+	char       *text;
+	uint64_t    text_size, text_cap;
+};
+uint32_t _fgnb_string(_fgnb_strings_t &strings, const char *str) {
+	fgn_hash_t hash = _fgn_str_hash(str);
+	if ((strings.ct + 1) * 2 > strings.slot_cap) {
+		free(strings.slots);
+		strings.slot_cap = strings.slot_cap == 0 ? 1024 : strings.slot_cap * 2;
+		strings.slots    = (uint32_t *)calloc(strings.slot_cap, sizeof(uint32_t));
+		for (int32_t i = 0; i < strings.ct; i++) {
+			int32_t slot = _fgn_index_slot(strings.hashes[i], strings.slot_cap);
+			while (strings.slots[slot] != 0)
+				slot = (slot + 1) & (strings.slot_cap - 1);
+			strings.slots[slot] = i + 1;
+		}
 	}
-	free(lib.graphs);
-	lib = {};
-}
-void    fgn_destroy  (fgn_graph_t &graph) {
-	fgn_data_destroy(graph.data);
-	for (int32_t i = 0; i < graph.edge_ct; i++) fgn_data_destroy(graph.edges[i].data);
-	for (int32_t i = 0; i < graph.node_ct; i++) fgn_destroy(graph.nodes[i]);
-	free(graph.edges);
-	free(graph.nodes);
-	free(graph.id);
-}
 
-///////////////////////////////////////////
+	int32_t slot = _fgn_index_slot(hash, strings.slot_cap);
+	while (strings.slots[slot] != 0) {
+		uint32_t i = strings.slots[slot] - 1;
+		if (strings.hashes[i] == hash && _fgn_str_eq(strings.text + strings.offsets[i], str))
+			return i;
+		slot = (slot + 1) & (strings.slot_cap - 1);
+	}
 
-fgn_graph_idx fgn_lib_add(fgn_library_t &lib, const char *id) {
-	fgn_graph_idx result = _fgn_arr_add(&lib.graphs, 1, lib.graph_ct, lib.graph_cap);
-	fgn_graph_set_id(lib.graphs[result], id);
+	size_t length = strlen(str) + 1;
+	if (strings.text_size + length > strings.text_cap) {
+		strings.text_cap = strings.text_cap * 2 > strings.text_size + length ? strings.text_cap * 2 : strings.text_size + length + 4096;
+		strings.text     = (char *)realloc(strings.text, strings.text_cap);
+	}
+	memcpy(strings.text + strings.text_size, str, length);
+
+	int32_t offset_ct = strings.ct;
+	int32_t result    = _fgn_arr_add(&strings.hashes,  1, strings.ct, strings.cap);
+	_fgn_arr_add(&strings.offsets, 1, offset_ct, strings.offset_cap);
+	strings.hashes [result] = hash;
+	strings.offsets[result] = strings.text_size;
+	strings.slots  [slot  ] = result + 1;
+	strings.text_size += length;
 	return result;
 }
-fgn_node_idx  fgn_lib_findid(const fgn_library_t &lib, const char *id) {
-	fgn_hash_t hash = _fgn_str_hash(id);
-	for (fgn_node_idx i = 0; i < lib.graph_ct; i++) {
-		if (hash == lib.graphs[i].id_hash && _fgn_str_eq(id, lib.graphs[i].id))
-			return i;
+
+// Turns a data block into string table pairs, including anything the
+// parser has to write from the parsed struct, same order as fgn_save.
+void _fgnb_pairs(_fgnb_strings_t &strings, fgn_parse_state_t state, const fgn_data_t *data, const fgn_parser_t *parser, void *parsed, _fgnb_pair_t **pairs, int32_t &pair_ct, int32_t &pair_cap) {
+	if (parser != nullptr && parsed != nullptr) {
+		for (int32_t i = 0; i < parser->item_ct; i++) {
+			const _fgn_parse_item_t &item  = parser->items[i];
+			void                    *value = ((uint8_t *)parsed) + item.offset;
+
+			// Values get written to the stack unless they're too big
+			char    buffer[256];
+			char   *text   = nullptr;
+			int32_t length = -1;
+			if (item.write != nullptr) {
+				length = item.write(state, value, buffer, sizeof(buffer) - 1);
+				text   = buffer;
+				if (length >= (int32_t)sizeof(buffer)) {
+					text = (char *)malloc(length + 1);
+					item.write(state, value, text, length);
+				}
+				if (length >= 0) text[length] = '\0';
+			} else if (item.write_str != nullptr) {
+				text   = item.write_str(state, value);
+				length = text == nullptr ? -1 : 0;
+			}
+			if (length >= 0) {
+				int32_t p = _fgn_arr_add(pairs, 1, pair_ct, pair_cap);
+				(*pairs)[p] = { _fgnb_string(strings, item.key), _fgnb_string(strings, text) };
+			}
+			if (text != buffer)
+				free(text);
+		}
+	}
+	for (int32_t i = 0; data != nullptr && i < data->pair_ct; i++) {
+		int32_t p = _fgn_arr_add(pairs, 1, pair_ct, pair_cap);
+		(*pairs)[p] = { _fgnb_string(strings, data->pairs[i].key), _fgnb_string(strings, data->pairs[i].value) };
 	}
-	return -1;
-}
-void fgn_lib_delete(fgn_library_t &lib, fgn_graph_idx graph_idx) {
-	assert(graph_idx >= 0 && graph_idx < lib.graph_ct);
-	fgn_destroy(lib.graphs[graph_idx]);
-	_fgn_arr_remove<fgn_graph_t>(&lib.graphs, graph_idx, lib.graph_ct);
 }
 
-///////////////////////////////////////////
-
-void          fgn_graph_set_id     (fgn_graph_t &graph, const char *id) {
-	graph.id      = _fgn_str_copy(id);
-	graph.id_hash = _fgn_str_hash(id);
+// Writes an array, and pads the file so the next one is 8 byte aligned.
+// Returns false on a short write.
+bool _fgnb_write(FILE *fp, uint64_t &at, const void *data, size_t size) {
+	const uint8_t zeros[8] = {};
+	bool   ok  = size == 0 || fwrite(data, size, 1, fp) == 1;
+	size_t pad = (8 - (size & 7)) & 7;
+	ok = (pad == 0 || fwrite(zeros, pad, 1, fp) == 1) && ok;
+	at += size + pad;
+	return ok;
 }
-fgn_node_idx  fgn_graph_node_add   (fgn_graph_t &graph, const char *id) {
-	assert(fgn_graph_node_findid(graph, id) == -1);
-	fgn_node_idx result = _fgn_arr_add(&graph.nodes, 1, graph.node_ct, graph.node_cap);
-	fgn_graph_node_setid(graph, result, id);
+// Steps over an array of count items in a loaded file, and returns where
+// it starts, or nullptr if it runs past end. Once a read fails, at is
+// nullptr and every read after it fails too.
+const void *_fgnb_read(const uint8_t *&at, const uint8_t *end, uint64_t count, size_t item_size) {
+	if (at == nullptr || count > (uint64_t)(end - at) / item_size) {
+		at = nullptr;
+		return nullptr;
+	}
+	const void *result = at;
+	uint64_t    size   = (count * item_size + 7) & ~(uint64_t)7;
+	at = size < (uint64_t)(end - at) ? at + size : end;
 	return result;
 }
-void          fgn_graph_node_setid (fgn_graph_t &graph, fgn_node_idx idx, const char *text_id) {
-	graph.nodes[idx].id      = _fgn_str_copy(text_id);
-	graph.nodes[idx].id_hash = _fgn_str_hash(text_id);
+const uint8_t *_fgnb_at(const uint8_t *file, uint64_t size, uint64_t offset) {
+	return offset <= size && (offset & 7) == 0 ? file + offset : nullptr;
 }
-fgn_node_idx  fgn_graph_node_findid(const fgn_graph_t &graph, const char *id) {
-	fgn_hash_t hash = _fgn_str_hash(id);
-	for (fgn_node_idx i = 0; i < graph.node_ct; i++) {
-		if (hash == graph.nodes[i].id_hash && _fgn_str_eq(id, graph.nodes[i].id))
-			return i;
+
+// Where one graph's arrays are in a loaded file
+struct _fgnb_graph_view_t {
+	const _fgnb_graph_t *info;
+	uint32_t             pair_ct; // Graph, node and edge pairs together
+	const _fgnb_pair_t  *pairs;
+	const uint32_t      *ids;
+	const float         *positions;
+	const uint32_t      *node_pairs;
+	const uint32_t      *ends;
+	const uint32_t      *edge_pairs;
+	const uint32_t      *out_starts;
+	fgn_edge_idx        *out_edges;
+	const uint32_t      *in_starts;
+	fgn_edge_idx        *in_edges;
+};
+// Finds a graph's arrays, and checks they're all inside the file, and
+// only refer to strings, pairs, nodes and edges that exist.
+bool _fgnb_graph_view(const uint8_t *file, uint64_t size, uint64_t offset, uint64_t string_ct, _fgnb_graph_view_t &view) {
+	const uint8_t *at  = _fgnb_at(file, size, offset);
+	const uint8_t *end = file + size;
+	view.info = (const _fgnb_graph_t *)_fgnb_read(at, end, 1, sizeof(_fgnb_graph_t));
+	if (view.info == nullptr)
+		return false;
+	const _fgnb_graph_t &info    = *view.info;
+	uint64_t             pair_ct = (uint64_t)info.pair_ct + info.node_pair_ct + info.edge_pair_ct;
+	if (pair_ct >= INT32_MAX || info.node_ct >= INT32_MAX || info.edge_ct >= INT32_MAX)
+		return false;
+	view.pair_ct    = (uint32_t)pair_ct;
+	view.pairs      = (const _fgnb_pair_t *)_fgnb_read(at, end, pair_ct,                  sizeof(_fgnb_pair_t));
+	view.ids        = (const uint32_t     *)_fgnb_read(at, end, info.node_ct,             sizeof(uint32_t));
+	view.positions  = (const float        *)_fgnb_read(at, end, info.node_ct * 3ull,      sizeof(float));
+	view.node_pairs = (const uint32_t     *)_fgnb_read(at, end, info.node_ct + 1ull,      sizeof(uint32_t));
+	view.ends       = (const uint32_t     *)_fgnb_read(at, end, info.edge_ct * 2ull,      sizeof(uint32_t));
+	view.edge_pairs = (const uint32_t     *)_fgnb_read(at, end, info.edge_ct + 1ull,      sizeof(uint32_t));
+	view.out_starts = (const uint32_t     *)_fgnb_read(at, end, info.node_ct + 1ull,      sizeof(uint32_t));
+	view.out_edges  = (fgn_edge_idx       *)_fgnb_read(at, end, info.edge_ct,             sizeof(int32_t));
+	view.in_starts  = (const uint32_t     *)_fgnb_read(at, end, info.node_ct + 1ull,      sizeof(uint32_t));
+	view.in_edges   = (fgn_edge_idx       *)_fgnb_read(at, end, info.edge_ct,             sizeof(int32_t));
+	if (at == nullptr)
+		return false;
+
+	for (uint32_t i = 0; i < view.pair_ct; i++) {
+		if (view.pairs[i].key >= string_ct || view.pairs[i].value >= string_ct)
+			return false;
 	}
-	return -1;
-}
-void          fgn_graph_node_delete(fgn_graph_t &graph, fgn_node_idx node) {
-	for (int32_t i = 0; i < graph.edge_ct; i++) {
-		fgn_edge_t &e = graph.edges[i];
-		if (e.start == node || e.end == node) {
-			fgn_graph_edge_delete(graph, i);
-			i--;
-		} else {
-			if (e.start > node) e.start--;
-			if (e.end   > node) e.end--;
-		}
+	for (uint32_t n = 0; n < info.node_ct; n++) {
+		if (view.ids[n] >= string_ct)
+			return false;
+	}
+	for (uint32_t e = 0; e < info.edge_ct * 2; e++) {
+		if (view.ends[e] >= info.node_ct)
+			return false;
 	}
 
-	fgn_destroy(graph.nodes[node]);
-	_fgn_arr_remove(&graph.nodes, node, graph.node_ct);
-}
-void          fgn_graph_node_delete(fgn_graph_t &graph, const char *node) {
-	fgn_graph_node_delete(graph, fgn_graph_node_findid(graph, node));
+	// Pair ranges go in order, from after the graph's own to the end
+	auto ranges_ok = [](const uint32_t *starts, uint32_t ct, uint32_t first, uint32_t last) {
+		if (starts[0] != first || starts[ct] != last)
+			return false;
+		for (uint32_t i = 0; i < ct; i++) {
+			if (starts[i + 1] < starts[i])
+				return false;
+		}
+		return true;
+	};
+	if (!ranges_ok(view.node_pairs, info.node_ct, info.pair_ct, info.pair_ct + info.node_pair_ct) ||
+		!ranges_ok(view.edge_pairs, info.edge_ct, info.pair_ct + info.node_pair_ct, view.pair_ct))
+		return false;
+
+	// And every edge a node lists has to actually start or end there
+	auto adjacency_ok = [&](const uint32_t *starts, const fgn_edge_idx *edges, const uint32_t *edge_nodes) {
+		if (!ranges_ok(starts, info.node_ct, 0, info.edge_ct))
+			return false;
+		for (uint32_t n = 0; n < info.node_ct; n++) {
+			for (uint32_t i = starts[n]; i < starts[n + 1]; i++) {
+				if (edges[i] < 0 || (uint32_t)edges[i] >= info.edge_ct || edge_nodes[edges[i]] != n)
+					return false;
+			}
+		}
+		return true;
+	};
+	return adjacency_ok(view.out_starts, view.out_edges, view.ends)
+		&& adjacency_ok(view.in_starts,  view.in_edges,  view.ends + info.edge_ct);
+}
+
+int32_t fgn_save_binary(fgn_library_t &lib, const char *filename, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	FILE *fp = nullptr;
+	if (fopen_s(&fp, filename, "wb") != 0 || fp == nullptr)
+		return 1;
+
+	_fgnb_strings_t strings = {};
+	_fgnb_header_t  header  = {};
+	uint64_t        at      = 0;
+	uint64_t       *graphs_at = (uint64_t *)malloc(sizeof(uint64_t) * (lib.graph_ct + 1));
+	bool            ok      = true;
+	memcpy(header.magic, "FGNB", 4);
+	header.version  = 1;
+	header.graph_ct = (uint32_t)lib.graph_ct;
+
+	// Header gets written again at the end, once we know the offsets
+	ok &= _fgnb_write(fp, at, &header, sizeof(header));
+
+	_fgnb_pair_t *pairs = nullptr;
+	int32_t       pair_ct = 0, pair_cap = 0;
+	fgn_graph_t   empty   = {};
+	_fgnb_pairs(strings, { empty, -1, -1 }, &lib.data, nullptr, nullptr, &pairs, pair_ct, pair_cap);
+	header.pair_ct = pair_ct;
+	ok &= _fgnb_write(fp, at, pairs, sizeof(_fgnb_pair_t) * pair_ct);
+
+	for (int32_t g = 0; g < lib.graph_ct; g++) {
+		fgn_graph_t      &graph = lib.graphs[g];
+		fgn_parse_state_t state = { graph, -1, -1 };
+		graphs_at[g] = at;
+
+		_fgnb_graph_t info = {};
+		info.id      = _fgnb_string(strings, graph.id);
+		info.node_ct = graph.node_ct;
+		info.edge_ct = graph.edge_ct;
+		pair_ct = 0;
+		_fgnb_pairs(strings, state, &graph.data, parser_graph, graph.data.data, &pairs, pair_ct, pair_cap);
+		info.pair_ct = pair_ct;
+
+		// Per node arrays, and the adjacency lists in CSR form
+		uint32_t *ids         = (uint32_t *)malloc(sizeof(uint32_t) * (graph.node_ct + 1));
+		float    *positions   = (float    *)malloc(sizeof(float) * 3 * (graph.node_ct + 1));
+		uint32_t *pair_starts = (uint32_t *)malloc(sizeof(uint32_t) * (graph.node_ct + graph.edge_ct + 2));
+		uint32_t *out_starts  = (uint32_t *)malloc(sizeof(uint32_t) * (graph.node_ct + 1));
+		uint32_t *in_starts   = (uint32_t *)malloc(sizeof(uint32_t) * (graph.node_ct + 1));
+		int32_t  *out_edges   = (int32_t  *)malloc(sizeof(int32_t ) * (graph.edge_ct + 1));
+		int32_t  *in_edges    = (int32_t  *)malloc(sizeof(int32_t ) * (graph.edge_ct + 1));
+		uint32_t  out_ct = 0, in_ct = 0;
+		for (int32_t n = 0; n < graph.node_ct; n++) {
+			fgn_node_t &node = graph.nodes[n];
+			ids[n] = _fgnb_string(strings, node.id);
+			memcpy(&positions[n * 3], fgn_graph_node_position(graph, n), sizeof(float) * 3);
+
+			out_starts[n] = out_ct;
+			in_starts [n] = in_ct;
+			int32_t node_out_ct = graph.node_out_cts[n], node_in_ct = graph.node_in_cts[n];
+			if (node_out_ct > 0) memcpy(&out_edges[out_ct], node.out_edges, sizeof(int32_t) * node_out_ct);
+			if (node_in_ct  > 0) memcpy(&in_edges [in_ct ], node.in_edges,  sizeof(int32_t) * node_in_ct );
+			out_ct += node_out_ct;
+			in_ct  += node_in_ct;
+
+			state.curr_node = n;
+			pair_starts[n] = pair_ct;
+			_fgnb_pairs(strings, state, node.data_ref != 0 ? &graph.node_data[node.data_ref - 1] : nullptr, parser_node, _fgn_parsed_node(graph, n), &pairs, pair_ct, pair_cap);
+		}
+		out_starts [graph.node_ct] = out_ct;
+		in_starts  [graph.node_ct] = in_ct;
+		pair_starts[graph.node_ct] = pair_ct;
+		info.node_pair_ct = pair_ct - info.pair_ct;
+		state.curr_node = -1;
+
+		uint32_t *ends       = (uint32_t *)malloc(sizeof(uint32_t) * 2 * (graph.edge_ct + 1));
+		uint32_t *edge_pairs = pair_starts + graph.node_ct + 1;
+		for (int32_t e = 0; e < graph.edge_ct; e++) {
+			ends[e]                 = graph.edges[e].start;
+			ends[graph.edge_ct + e] = graph.edges[e].end;
+			state.curr_edge = e;
+			edge_pairs[e] = pair_ct;
+			int32_t data_ref = graph.edges[e].data_ref;
+			_fgnb_pairs(strings, state, data_ref != 0 ? &graph.edge_data[data_ref - 1] : nullptr, parser_edge, _fgn_parsed_edge(graph, e), &pairs, pair_ct, pair_cap);
+		}
+		edge_pairs[graph.edge_ct] = pair_ct;
+		info.edge_pair_ct = pair_ct - info.node_pair_ct - info.pair_ct;
+
+		ok &= _fgnb_write(fp, at, &info,        sizeof(info));
+		ok &= _fgnb_write(fp, at, pairs,        sizeof(_fgnb_pair_t) * pair_ct);
+		ok &= _fgnb_write(fp, at, ids,          sizeof(uint32_t) * graph.node_ct);
+		ok &= _fgnb_write(fp, at, positions,    sizeof(float) * 3 * graph.node_ct);
+		ok &= _fgnb_write(fp, at, pair_starts,  sizeof(uint32_t) * (graph.node_ct + 1));
+		ok &= _fgnb_write(fp, at, ends,         sizeof(uint32_t) * 2 * graph.edge_ct);
+		ok &= _fgnb_write(fp, at, edge_pairs,   sizeof(uint32_t) * (graph.edge_ct + 1));
+		ok &= _fgnb_write(fp, at, out_starts,   sizeof(uint32_t) * (graph.node_ct + 1));
+		ok &= _fgnb_write(fp, at, out_edges,    sizeof(int32_t ) * graph.edge_ct);
+		ok &= _fgnb_write(fp, at, in_starts,    sizeof(uint32_t) * (graph.node_ct + 1));
+		ok &= _fgnb_write(fp, at, in_edges,     sizeof(int32_t ) * graph.edge_ct);
+
+		free(ids); free(positions); free(pair_starts); free(ends);
+		free(out_starts); free(in_starts); free(out_edges); free(in_edges);
+	}
+	header.graphs_at = at;
+	ok &= _fgnb_write(fp, at, graphs_at, sizeof(uint64_t) * lib.graph_ct);
+
+	header.string_ct  = strings.ct;
+	header.strings_at = at;
+	ok &= _fgnb_write(fp, at, strings.hashes,  sizeof(fgn_hash_t) * strings.ct);
+	ok &= _fgnb_write(fp, at, strings.offsets, sizeof(uint64_t)   * strings.ct);
+	ok &= _fgnb_write(fp, at, strings.text,    strings.text_size);
+
+	ok &= fseek(fp, 0, SEEK_SET) == 0;
+	ok &= fwrite(&header, sizeof(header), 1, fp) == 1;
+	ok &= fclose(fp) == 0;
+
+	free(pairs);
+	free(graphs_at);
+	free(strings.slots);
+	free(strings.hashes);
+	free(strings.offsets);
+	free(strings.text);
+	return ok ? 0 : 2;
+}
+
+int32_t fgn_load_binary(fgn_library_t &lib, const char *filename) {
+	bool new_mem = lib.mem == nullptr;
+	if (new_mem)
+		lib.mem = _fgn_mem_create();
+	_fgn_mem_t    *mem  = lib.mem;
+	size_t         size = 0;
+	const uint8_t *file = (const uint8_t *)_fgn_mem_map_file(mem, filename, &size);
+
+	// Failing gives back the file, and any memory made just for it
+	auto fail = [&](int32_t result) {
+		if (file != nullptr) _fgn_mem_release(mem, file);
+		if (new_mem) {
+			_fgn_mem_destroy(lib.mem);
+			lib.mem = nullptr;
+		}
+		return result;
+	};
+	if (file == nullptr)
+		return fail(1);
+	const _fgnb_header_t *header = (const _fgnb_header_t *)file;
+	if (size < sizeof(_fgnb_header_t) || memcmp(header->magic, "FGNB", 4) != 0 || header->version != 1)
+		return fail(2);
+
+	// Nothing gets added to the library until the whole file checks out,
+	// so a truncated or corrupt file leaves it as it was.
+	const uint8_t    *end       = file + size;
+	const uint64_t    string_ct = header->string_ct;
+	const uint8_t    *at        = _fgnb_at(file, size, header->strings_at);
+	const fgn_hash_t *hashes    = (const fgn_hash_t *)_fgnb_read(at, end, string_ct, sizeof(fgn_hash_t));
+	const uint64_t   *offsets   = (const uint64_t   *)_fgnb_read(at, end, string_ct, sizeof(uint64_t));
+	char             *text      = (char *)at;
+	uint64_t          text_size = at == nullptr ? 0 : (uint64_t)(end - at);
+
+	// Strings run to the end of the file, so if its last byte is a
+	// terminator, any offset inside the text is a terminated string.
+	bool ok = at != nullptr && (string_ct == 0 || (text_size > 0 && text[text_size - 1] == '\0'));
+	for (uint64_t i = 0; ok && i < string_ct; i++)
+		ok = offsets[i] < text_size;
+
+	at = file + sizeof(_fgnb_header_t);
+	const _fgnb_pair_t *lib_pairs = (const _fgnb_pair_t *)_fgnb_read(at, end, header->pair_ct, sizeof(_fgnb_pair_t));
+	ok = ok && lib_pairs != nullptr;
+	for (uint32_t i = 0; ok && i < header->pair_ct; i++)
+		ok = lib_pairs[i].key < string_ct && lib_pairs[i].value < string_ct;
+
+	at = _fgnb_at(file, size, header->graphs_at);
+	const uint64_t     *graphs = (const uint64_t *)_fgnb_read(at, end, header->graph_ct, sizeof(uint64_t));
+	_fgnb_graph_view_t *views  = nullptr;
+	ok = ok && graphs != nullptr && header->graph_ct < INT32_MAX;
+	if (ok)
+		views = (_fgnb_graph_view_t *)malloc(sizeof(_fgnb_graph_view_t) * (header->graph_ct + 1));
+	for (uint32_t g = 0; ok && g < header->graph_ct; g++)
+		ok = _fgnb_graph_view(file, size, graphs[g], string_ct, views[g]) && views[g].info->id < string_ct;
+	if (!ok) {
+		free(views);
+		return fail(3);
+	}
+
+	// Pairs are borrowed lists, each one headed by the memory it's from
+	auto load_pairs = [&](fgn_data_t &data, const _fgnb_pair_t *pairs, uint32_t pair_ct, uint8_t *&dest) {
+		if (pair_ct == 0 && !mem->arena)
+			return;
+		*(_fgn_pairs_head_t *)dest = { mem, nullptr, nullptr };
+		data.pairs    = (_fgn_pair_t *)(dest + sizeof(_fgn_pairs_head_t));
+		data.pair_ct  = pair_ct;
+		data.pair_cap = ~(int32_t)pair_ct;
+		for (uint32_t i = 0; i < pair_ct; i++) {
+			data.pairs[i].key      = text + offsets[pairs[i].key];
+			data.pairs[i].key_hash = hashes[pairs[i].key];
+			data.pairs[i].value    = text + offsets[pairs[i].value];
+		}
+		dest += sizeof(_fgn_pairs_head_t) + sizeof(_fgn_pair_t) * pair_ct;
+	};
+
+	for (uint32_t i = 0; i < header->pair_ct; i++)
+		_fgn_data_add(lib.data, mem, text + offsets[lib_pairs[i].key], hashes[lib_pairs[i].key], text + offsets[lib_pairs[i].value]);
+
+	for (uint32_t g = 0; g < header->graph_ct; g++) {
+		const _fgnb_graph_view_t &view = views[g];
+		const _fgnb_graph_t      *info = view.info;
+		const _fgnb_pair_t       *pairs = view.pairs;
+
+		fgn_graph_idx graph_idx = _fgn_lib_add(lib, text + offsets[info->id]);
+		fgn_graph_t  &graph     = lib.graphs[graph_idx];
+		for (uint32_t i = 0; i < info->pair_ct; i++)
+			_fgn_data_add(graph.data, mem, text + offsets[pairs[i].key], hashes[pairs[i].key], text + offsets[pairs[i].value]);
+
+		// Nodes, edges and all their pair lists are a few bulk allocations
+		uint8_t *dest = (uint8_t *)_fgn_mem_alloc(mem, sizeof(_fgn_pair_t) * view.pair_ct + sizeof(_fgn_pairs_head_t) * (info->node_ct + info->edge_ct));
+		graph.nodes    = (fgn_node_t *)_fgn_mem_alloc(mem, sizeof(fgn_node_t) * info->node_ct);
+		graph.node_ct  = info->node_ct;
+		graph.node_cap = ~(int32_t)info->node_ct;
+		graph.edges    = (fgn_edge_t *)_fgn_mem_alloc(mem, sizeof(fgn_edge_t) * info->edge_ct);
+		graph.edge_ct  = info->edge_ct;
+		graph.edge_cap = ~(int32_t)info->edge_ct;
+		memset(graph.nodes, 0, sizeof(fgn_node_t) * info->node_ct);
+		memset(graph.edges, 0, sizeof(fgn_edge_t) * info->edge_ct);
+		_fgn_columns_grow(graph, info->node_ct);
+		if (info->node_ct > 0)
+			memcpy(graph.node_positions, view.positions, sizeof(float) * 3 * info->node_ct);
+
+		for (uint32_t n = 0; n < info->node_ct; n++) {
+			fgn_node_t &node = graph.nodes[n];
+			int32_t out_ct = view.out_starts[n + 1] - view.out_starts[n];
+			int32_t in_ct  = view.in_starts [n + 1] - view.in_starts [n];
+			node.id               = text + offsets[view.ids[n]];
+			graph.node_hashes [n] = hashes[view.ids[n]];
+			graph.node_out_cts[n] = out_ct;
+			graph.node_in_cts [n] = in_ct;
+			if (out_ct > 0) { node.out_edges = &view.out_edges[view.out_starts[n]]; node.out_cap = ~out_ct; }
+			if (in_ct  > 0) { node.in_edges  = &view.in_edges [view.in_starts [n]]; node.in_cap  = ~in_ct;  }
+			_fgn_node_relink(node);
+			if (view.node_pairs[n + 1] > view.node_pairs[n])
+				load_pairs(_fgn_node_data_add(graph, n), &pairs[view.node_pairs[n]], view.node_pairs[n + 1] - view.node_pairs[n], dest);
+		}
+		for (uint32_t e = 0; e < info->edge_ct; e++) {
+			fgn_edge_t &edge = graph.edges[e];
+			edge.start = view.ends[e];
+			edge.end   = view.ends[info->edge_ct + e];
+			if (view.edge_pairs[e + 1] > view.edge_pairs[e])
+				load_pairs(_fgn_edge_data_add(graph, e), &pairs[view.edge_pairs[e]], view.edge_pairs[e + 1] - view.edge_pairs[e], dest);
+		}
+		_fgn_index_build(graph);
+	}
+	free(views);
+	return 0;
+}
+
+///////////////////////////////////////////
+
+void    _fgn_destroy (fgn_node_t &node, const _fgn_mem_t *mem) {
+	if (!_fgn_mem_owns(mem, node.id))
+		free(node.id);
+	if (node.in_cap  > 0) free(node.in_edges);
+	if (node.out_cap > 0) free(node.out_edges);
+}
+void    _fgn_node_relink  (fgn_node_t &node) {
+	// A capacity of 0 means the list lives inside the node
+	if (node.in_cap  == 0) node.in_edges  = node._in_inline;
+	if (node.out_cap == 0) node.out_edges = node._out_inline;
+}
+void    _fgn_node_edge_add(const fgn_graph_t &graph, fgn_edge_idx **list, int32_t &count, int32_t &capacity, fgn_edge_idx *inline_list, fgn_edge_idx edge) {
+	if (capacity == 0) {
+		if (count < _FGN_INLINE_EDGES) {
+			*list = inline_list;
+			inline_list[count++] = edge;
+			return;
+		}
+		// Out of room in the node, move the list to its own allocation
+		fgn_edge_idx *heap    = nullptr;
+		int32_t       heap_ct = 0;
+		_fgn_graph_arr_add(graph, &heap, count + 1, heap_ct, capacity);
+		memcpy(heap, inline_list, sizeof(fgn_edge_idx) * count);
+		heap[count] = edge;
+		*list = heap;
+		count = heap_ct;
+		return;
+	}
+	int32_t i = _fgn_graph_arr_add(graph, list, 1, count, capacity);
+	(*list)[i] = edge;
+}
+void    fgn_destroy  (fgn_library_t &lib) {
+	_fgn_data_destroy(lib.data, lib.mem);
+	for (int32_t i = 0; i < lib.graph_ct; i++) {
+		fgn_destroy(lib.graphs[i]);
+	}
+	free(lib.graphs);
+	_fgn_mem_destroy(lib.mem);
+	lib = {};
+}
+void    fgn_destroy  (fgn_graph_t &graph) {
+	// Arena graphs keep their nodes, edges and data in library memory,
+	// so there's nothing to walk, fgn_destroy(lib) frees it all at once.
+	if (!_fgn_graph_arena(graph)) {
+		_fgn_data_destroy(graph.data, graph.mem);
+		for (int32_t i = 0; i < graph.node_data_ct; i++) _fgn_data_destroy(graph.node_data[i], graph.mem);
+		for (int32_t i = 0; i < graph.edge_data_ct; i++) _fgn_data_destroy(graph.edge_data[i], graph.mem);
+		for (int32_t i = 0; i < graph.node_ct;      i++) _fgn_destroy(graph.nodes[i], graph.mem);
+	}
+	if (graph.edge_cap > 0) free(graph.edges);
+	if (graph.node_cap > 0) free(graph.nodes);
+	free(graph.node_index);
+	_fgn_slots_destroy(graph.node_slots);
+	_fgn_slots_destroy(graph.edge_slots);
+	free(graph.node_data);
+	free(graph.node_data_free);
+	free(graph.edge_data);
+	free(graph.edge_data_free);
+	free(graph.node_hashes);
+	free(graph.node_positions);
+	free(graph.node_in_cts);
+	free(graph.node_out_cts);
+	free(graph.node_structs.data);
+	free(graph.node_structs.parsed);
+	free(graph.edge_structs.data);
+	free(graph.edge_structs.parsed);
+	if (!_fgn_mem_owns(graph.mem, graph.id))
+		free(graph.id);
+}
+
+///////////////////////////////////////////
+
+void          fgn_lib_use_arena(fgn_library_t &lib) {
+	assert(lib.graph_ct == 0 && lib.data.pair_ct == 0);
+	if (lib.mem == nullptr)
+		lib.mem = _fgn_mem_create();
+	lib.mem->arena      = true;
+	lib.mem->chunk_size = 1024 * 1024;
+	_fgn_data_borrow(lib.data, lib.mem);
+}
+void          fgn_lib_share_values(fgn_library_t &lib) {
+	assert(lib.graph_ct == 0 && lib.data.pair_ct == 0);
+	if (lib.mem == nullptr)
+		lib.mem = _fgn_mem_create();
+	lib.mem->share_values = true;
+	_fgn_data_borrow(lib.data, lib.mem);
+}
+fgn_value_stats_t fgn_lib_value_stats(const fgn_library_t &lib) {
+	fgn_value_stats_t result = {};
+
+	// Distinct value pointers go in an open addressing set, sized so it
+	// stays at most half full even if every value is unique.
+	int64_t pair_ct = lib.data.pair_ct;
+	for (int32_t g = 0; g < lib.graph_ct; g++) {
+		const fgn_graph_t &graph = lib.graphs[g];
+		pair_ct += graph.data.pair_ct;
+		for (int32_t i = 0; i < graph.node_data_ct; i++) pair_ct += graph.node_data[i].pair_ct;
+		for (int32_t i = 0; i < graph.edge_data_ct; i++) pair_ct += graph.edge_data[i].pair_ct;
+	}
+	int32_t      cap  = 16;
+	while (cap < pair_ct * 2) cap *= 2;
+	const char **seen = (const char **)calloc(cap, sizeof(const char *));
+
+	auto count = [&](const fgn_data_t &data) {
+		for (int32_t i = 0; i < data.pair_ct; i++) {
+			const char *value = data.pairs[i].value;
+			int64_t     size  = (int64_t)strlen(value) + 1;
+			result.value_ct    += 1;
+			result.value_bytes += size;
+
+			int32_t slot = _fgn_index_slot((fgn_hash_t)(uintptr_t)value * 11400714819323198485ull, cap);
+			while (seen[slot] != nullptr && seen[slot] != value)
+				slot = (slot + 1) & (cap - 1);
+			if (seen[slot] == nullptr) {
+				seen[slot] = value;
+				result.unique_ct    += 1;
+				result.stored_bytes += size;
+			}
+		}
+	};
+	count(lib.data);
+	for (int32_t g = 0; g < lib.graph_ct; g++) {
+		const fgn_graph_t &graph = lib.graphs[g];
+		count(graph.data);
+		for (int32_t i = 0; i < graph.node_data_ct; i++) count(graph.node_data[i]);
+		for (int32_t i = 0; i < graph.edge_data_ct; i++) count(graph.edge_data[i]);
+	}
+	free(seen);
+	return result;
+}
+fgn_graph_idx fgn_lib_add(fgn_library_t &lib, const char *id) {
+	return _fgn_lib_add(lib, lib.mem != nullptr && lib.mem->arena ? _fgn_mem_str(lib.mem, id) : _fgn_str_copy(id));
+}
+fgn_graph_idx _fgn_lib_add(fgn_library_t &lib, char *id) {
+	fgn_graph_idx result = _fgn_arr_add(&lib.graphs, 1, lib.graph_ct, lib.graph_cap);
+	fgn_graph_t  &graph  = lib.graphs[result];
+	graph.id      = id;
+	graph.id_hash = _fgn_str_hash(id);
+	graph.mem     = lib.mem;
+	if (_fgn_graph_borrows(graph))
+		_fgn_data_borrow(graph.data, graph.mem);
+	return result;
+}
+fgn_node_idx  fgn_lib_findid(const fgn_library_t &lib, const char *id) {
+	fgn_hash_t hash = _fgn_str_hash(id);
+	for (fgn_node_idx i = 0; i < lib.graph_ct; i++) {
+		if (hash == lib.graphs[i].id_hash && _fgn_str_eq(id, lib.graphs[i].id))
+			return i;
+	}
+	return -1;
+}
+void fgn_lib_delete(fgn_library_t &lib, fgn_graph_idx graph_idx) {
+	assert(graph_idx >= 0 && graph_idx < lib.graph_ct);
+	fgn_destroy(lib.graphs[graph_idx]);
+	_fgn_arr_remove<fgn_graph_t>(&lib.graphs, graph_idx, lib.graph_ct);
+}
+void _fgn_graph_share_values(fgn_graph_t &graph, _fgn_mem_t *mem) {
+	auto share = [mem](fgn_data_t &data) {
+		for (int32_t i = 0; i < data.pair_ct; i++) {
+			char  *value  = data.pairs[i].value;
+			size_t length = strlen(value);
+			data.pairs[i].value = _fgn_mem_intern(mem, value, length, _fgn_str_hash_n(value, length));
+		}
+	};
+	share(graph.data);
+	for (int32_t i = 0; i < graph.node_data_ct; i++) share(graph.node_data[i]);
+	for (int32_t i = 0; i < graph.edge_data_ct; i++) share(graph.edge_data[i]);
+}
+void _fgn_lib_rollback(fgn_library_t &lib, int32_t graph_ct, int32_t pair_ct) {
+	for (int32_t i = graph_ct; i < lib.graph_ct; i++)
+		fgn_destroy(lib.graphs[i]);
+	lib.graph_ct = graph_ct;
+
+	// Same rules as fgn_data_remove, borrowed strings stay where they are
+	fgn_data_t &data = lib.data;
+	if (data.pair_cap > 0) {
+		for (int32_t i = pair_ct; i < data.pair_ct; i++) {
+			if (!_fgn_mem_owns(_fgn_data_key_mem(data), data.pairs[i].key))
+				free(data.pairs[i].key);
+			free(data.pairs[i].value);
+		}
+	}
+	if (data.pair_ct != pair_ct) {
+		data.pair_ct = pair_ct;
+		_fgn_data_index_drop(data);
+	}
+}
+
+///////////////////////////////////////////
+
+void          fgn_graph_set_id     (fgn_graph_t &graph, const char *id) {
+	graph.id      = _fgn_str_copy(id);
+	graph.id_hash = _fgn_str_hash(id);
+}
+fgn_node_idx  fgn_graph_node_add   (fgn_graph_t &graph, const char *id) {
+	return _fgn_graph_node_add(graph, _fgn_graph_arena(graph) ? _fgn_mem_str(graph.mem, id) : _fgn_str_copy(id), _fgn_str_hash(id));
+}
+fgn_node_idx  _fgn_graph_node_add  (fgn_graph_t &graph, char *id, fgn_hash_t id_hash) {
+	assert(_fgn_index_find(graph, id_hash, id, strlen(id)) == -1);
+	fgn_node_t  *old_nodes = graph.nodes;
+	fgn_node_idx result    = _fgn_graph_arr_add(graph, &graph.nodes, 1, graph.node_ct, graph.node_cap);
+	if (graph.nodes != old_nodes) {
+		for (int32_t i = 0; i < result; i++) _fgn_node_relink(graph.nodes[i]);
+	}
+	_fgn_node_relink(graph.nodes[result]);
+	graph.nodes[result].id = id;
+	_fgn_columns_grow(graph, graph.node_ct);
+	graph.node_hashes [result] = id_hash;
+	graph.node_in_cts [result] = 0;
+	graph.node_out_cts[result] = 0;
+	memset(&graph.node_positions[result * 3], 0, sizeof(float) * 3);
+	if (graph.node_structs.data != nullptr)
+		_fgn_structs_add(graph.node_structs, result);
+	_fgn_index_add(graph, result);
+	if (graph.node_slots != nullptr)
+		_fgn_slots_add(graph.node_slots, result);
+	return result;
+}
+void          fgn_graph_node_setid (fgn_graph_t &graph, fgn_node_idx idx, const char *text_id) {
+	fgn_node_t &node = graph.nodes[idx];
+	if (node.id != nullptr) {
+		_fgn_index_remove(graph, idx);
+		if (!_fgn_mem_owns(graph.mem, node.id))
+			free(node.id);
+	}
+	node.id                = _fgn_graph_arena(graph) ? _fgn_mem_str(graph.mem, text_id) : _fgn_str_copy(text_id);
+	graph.node_hashes[idx] = _fgn_str_hash(text_id);
+	_fgn_index_add(graph, idx);
+}
+fgn_node_idx  fgn_graph_node_findid(const fgn_graph_t &graph, const char *id) {
+	return _fgn_index_find(graph, _fgn_str_hash(id), id, strlen(id));
+}
+void          fgn_graph_node_delete(fgn_graph_t &graph, fgn_node_idx node) {
+	// The node's own edges are all listed on it
+	fgn_node_t &n = graph.nodes[node];
+	while (graph.node_out_cts[node] > 0) fgn_graph_edge_delete(graph, n.out_edges[graph.node_out_cts[node] - 1]);
+	while (graph.node_in_cts [node] > 0) fgn_graph_edge_delete(graph, n.in_edges [graph.node_in_cts [node] - 1]);
+
+	// With handles, indices aren't what people hold on to, so fill the gap
+	// with the last node and patch up the few things that point at it.
+	if (graph.node_slots != nullptr) {
+		_fgn_index_remove(graph, node);
+		_fgn_node_data_free(graph, node);
+		_fgn_destroy(n, graph.mem);
+		fgn_node_idx last = graph.node_ct - 1;
+		if (node != last) {
+			n = graph.nodes[last];
+			_fgn_node_relink(n);
+			_fgn_columns_copy(graph, last, node);
+			for (int32_t i = 0; i < graph.node_out_cts[node]; i++) graph.edges[n.out_edges[i]].start = node;
+			for (int32_t i = 0; i < graph.node_in_cts [node]; i++) graph.edges[n.in_edges [i]].end   = node;
+			if (graph.node_structs.data != nullptr)
+				_fgn_structs_copy(graph.node_structs, last, node);
+			_fgn_index_move(graph, last, node);
+		}
+		graph.node_ct -= 1;
+		_fgn_slots_remove(graph.node_slots, node, node == last ? -1 : last);
+		return;
+	}
+
+	// Everything after this node shifts down in the node array
+	for (int32_t i = 0; i < graph.edge_ct; i++) {
+		fgn_edge_t &e = graph.edges[i];
+		if (e.start > node) e.start--;
+		if (e.end   > node) e.end--;
+	}
+
+	// Drop the node from the id index, and shift the indices of 
+	// everything that moves down in the node array.
+	_fgn_index_remove(graph, node);
+	for (int32_t i = 0; i < graph.node_index_cap; i++) {
+		if (graph.node_index[i] > node + 1)
+			graph.node_index[i] -= 1;
+	}
+
+	_fgn_node_data_free(graph, node);
+	_fgn_destroy(graph.nodes[node], graph.mem);
+	_fgn_arr_remove(&graph.nodes, node, graph.node_ct);
+	for (int32_t i = node; i < graph.node_ct; i++) _fgn_node_relink(graph.nodes[i]);
+	_fgn_columns_remove(graph, node);
+	if (graph.node_structs.data != nullptr)
+		_fgn_structs_remove(graph.node_structs, node, graph.node_ct);
+}
+void          fgn_graph_nodes_delete(fgn_graph_t &graph, const fgn_node_idx *nodes, int32_t count, fgn_node_idx *out_node_remap, fgn_edge_idx *out_edge_remap) {
+	fgn_node_idx *node_map = out_node_remap != nullptr ? out_node_remap : (fgn_node_idx *)malloc(sizeof(fgn_node_idx) * (graph.node_ct + 1));
+	fgn_edge_idx *edge_map = out_edge_remap != nullptr ? out_edge_remap : (fgn_edge_idx *)malloc(sizeof(fgn_edge_idx) * (graph.edge_ct + 1));
+
+	// Mark the victims, then number everything that survives in order.
+	// Edges go along with either of their nodes.
+	memset(node_map, 0, sizeof(fgn_node_idx) * graph.node_ct);
+	for (int32_t i = 0; i < count; i++)
+		node_map[nodes[i]] = -1;
+	fgn_node_idx next_node = 0;
+	for (int32_t i = 0; i < graph.node_ct; i++)
+		if (node_map[i] != -1) node_map[i] = next_node++;
+	fgn_edge_idx next_edge = 0;
+	for (int32_t i = 0; i < graph.edge_ct; i++)
+		edge_map[i] = node_map[graph.edges[i].start] == -1 || node_map[graph.edges[i].end] == -1 ? -1 : next_edge++;
+
+	int32_t old_node_ct = graph.node_ct;
+	int32_t old_edge_ct = graph.edge_ct;
+	_fgn_graph_compact(graph, node_map, edge_map);
+	if (graph.node_slots != nullptr) _fgn_slots_compact(graph.node_slots, node_map, old_node_ct);
+	if (graph.edge_slots != nullptr) _fgn_slots_compact(graph.edge_slots, edge_map, old_edge_ct);
+
+	if (out_node_remap == nullptr) free(node_map);
+	if (out_edge_remap == nullptr) free(edge_map);
+}
+void          fgn_graph_node_delete(fgn_graph_t &graph, const char *node) {
+	fgn_graph_node_delete(graph, fgn_graph_node_findid(graph, node));
 
 }
 
 fgn_edge_idx  fgn_graph_edge_add   (fgn_graph_t &graph, fgn_node_idx start, fgn_node_idx end) {
 	assert(start >= 0 && end >= 0 && start < graph.node_ct && end < graph.node_ct);
 	assert(start != end);
-	fgn_edge_idx result = _fgn_arr_add(&graph.edges, 1, graph.edge_ct, graph.edge_cap);
+	fgn_edge_idx result = _fgn_graph_arr_add(graph, &graph.edges, 1, graph.edge_ct, graph.edge_cap);
 	graph.edges[result].start = start;
 	graph.edges[result].end   = end;
 
 	// Cache edges on the node for fast lookup
 	fgn_node_t &node_s = graph.nodes[start];
-	node_s.out_edges[_fgn_arr_add(&node_s.out_edges, 1, node_s.out_ct, node_s.out_cap)] = result;
+	_fgn_node_edge_add(graph, &node_s.out_edges, graph.node_out_cts[start], node_s.out_cap, node_s._out_inline, result);
 	fgn_node_t &node_e = graph.nodes[end];
-	node_e.in_edges [_fgn_arr_add(&node_e.in_edges,  1, node_e.in_ct,  node_e.in_cap )] = result;
+	_fgn_node_edge_add(graph, &node_e.in_edges,  graph.node_in_cts [end],   node_e.in_cap,  node_e._in_inline,  result);
+	if (graph.edge_structs.data != nullptr)
+		_fgn_structs_add(graph.edge_structs, result);
+	if (graph.edge_slots != nullptr)
+		_fgn_slots_add(graph.edge_slots, result);
+	return result;
+}
+fgn_data_t   &fgn_graph_node_pairs (fgn_graph_t &graph, fgn_node_idx idx) {
+	if (graph.nodes[idx].data_ref != 0)
+		return graph.node_data[graph.nodes[idx].data_ref - 1];
+	fgn_data_t &result = _fgn_node_data_add(graph, idx);
+	if (_fgn_graph_borrows(graph))
+		_fgn_data_borrow(result, graph.mem);
+	return result;
+}
+fgn_data_t   &_fgn_node_data_add   (fgn_graph_t &graph, fgn_node_idx node) {
+	int32_t i = graph.node_data_free_ct > 0
+		? graph.node_data_free[--graph.node_data_free_ct]
+		: _fgn_arr_add(&graph.node_data, 1, graph.node_data_ct, graph.node_data_cap);
+	graph.node_data[i]         = {};
+	graph.nodes[node].data_ref = i + 1;
+	return graph.node_data[i];
+}
+void          _fgn_node_data_free  (fgn_graph_t &graph, fgn_node_idx node) {
+	int32_t i = graph.nodes[node].data_ref - 1;
+	if (i < 0) return;
+	_fgn_data_destroy(graph.node_data[i], graph.mem);
+	graph.node_data[i]         = {};
+	graph.nodes[node].data_ref = 0;
+	int32_t f = _fgn_arr_add(&graph.node_data_free, 1, graph.node_data_free_ct, graph.node_data_free_cap);
+	graph.node_data_free[f] = i;
+}
+fgn_data_t   &fgn_graph_edge_pairs (fgn_graph_t &graph, fgn_edge_idx idx) {
+	if (graph.edges[idx].data_ref != 0)
+		return graph.edge_data[graph.edges[idx].data_ref - 1];
+	fgn_data_t &result = _fgn_edge_data_add(graph, idx);
+	if (_fgn_graph_borrows(graph))
+		_fgn_data_borrow(result, graph.mem);
 	return result;
 }
+fgn_data_t   &_fgn_edge_data_add   (fgn_graph_t &graph, fgn_edge_idx edge) {
+	int32_t i = graph.edge_data_free_ct > 0
+		? graph.edge_data_free[--graph.edge_data_free_ct]
+		: _fgn_arr_add(&graph.edge_data, 1, graph.edge_data_ct, graph.edge_data_cap);
+	graph.edge_data[i]         = {};
+	graph.edges[edge].data_ref = i + 1;
+	return graph.edge_data[i];
+}
+void          _fgn_edge_data_free  (fgn_graph_t &graph, fgn_edge_idx edge) {
+	int32_t i = graph.edges[edge].data_ref - 1;
+	if (i < 0) return;
+	_fgn_data_destroy(graph.edge_data[i], graph.mem);
+	graph.edge_data[i]         = {};
+	graph.edges[edge].data_ref = 0;
+	int32_t f = _fgn_arr_add(&graph.edge_data_free, 1, graph.edge_data_free_ct, graph.edge_data_free_cap);
+	graph.edge_data_free[f] = i;
+}
 fgn_edge_idx  fgn_graph_edge_add   (fgn_graph_t &graph, const char *start, const char *end) {
 	return fgn_graph_edge_add(graph, fgn_graph_node_findid(graph, start), fgn_graph_node_findid(graph, end));
 }
-void          fgn_graph_edge_delete(fgn_graph_t &graph, fgn_edge_idx edge) {
-	fgn_data_destroy(graph.edges->data);
-	_fgn_arr_remove(&graph.edges, edge, graph.edge_ct);
+fgn_edge_idx  fgn_graph_edge_delete(fgn_graph_t &graph, fgn_edge_idx edge) {
+	_fgn_edge_data_free(graph, edge);
+	fgn_edge_t &e = graph.edges[edge];
+
+	// Only the two end nodes know about this edge
+	fgn_node_t &start = graph.nodes[e.start];
+	int32_t    &out_ct = graph.node_out_cts[e.start];
+	for (int32_t i = 0; i < out_ct; i++) {
+		if (start.out_edges[i] == edge) { _fgn_arr_remove(&start.out_edges, i, out_ct); break; }
+	}
+	fgn_node_t &end   = graph.nodes[e.end];
+	int32_t    &in_ct = graph.node_in_cts[e.end];
+	for (int32_t i = 0; i < in_ct; i++) {
+		if (end.in_edges[i] == edge) { _fgn_arr_remove(&end.in_edges, i, in_ct); break; }
+	}
+
+	// Fill the gap with the last edge, and point its nodes at the new spot
+	fgn_edge_idx last = graph.edge_ct - 1;
+	graph.edge_ct -= 1;
+	if (graph.edge_slots != nullptr)
+		_fgn_slots_remove(graph.edge_slots, edge, edge == last ? -1 : last);
+	if (edge == last)
+		return -1;
+
+	e = graph.edges[last];
+	if (graph.edge_structs.data != nullptr)
+		_fgn_structs_copy(graph.edge_structs, last, edge);
+	fgn_node_t &moved_start = graph.nodes[e.start];
+	for (int32_t i = 0; i < graph.node_out_cts[e.start]; i++) {
+		if (moved_start.out_edges[i] == last) { moved_start.out_edges[i] = edge; break; }
+	}
+	fgn_node_t &moved_end = graph.nodes[e.end];
+	for (int32_t i = 0; i < graph.node_in_cts[e.end]; i++) {
+		if (moved_end.in_edges[i] == last) { moved_end.in_edges[i] = edge; break; }
+	}
+	return last;
+}
+void          fgn_graph_edges_delete(fgn_graph_t &graph, const fgn_edge_idx *edges, int32_t count, fgn_edge_idx *out_edge_remap) {
+	fgn_edge_idx *edge_map = out_edge_remap != nullptr ? out_edge_remap : (fgn_edge_idx *)malloc(sizeof(fgn_edge_idx) * (graph.edge_ct + 1));
+
+	memset(edge_map, 0, sizeof(fgn_edge_idx) * graph.edge_ct);
+	for (int32_t i = 0; i < count; i++)
+		edge_map[edges[i]] = -1;
+	fgn_edge_idx next_edge = 0;
+	for (int32_t i = 0; i < graph.edge_ct; i++)
+		if (edge_map[i] != -1) edge_map[i] = next_edge++;
 
+	int32_t old_edge_ct = graph.edge_ct;
+	_fgn_graph_compact(graph, nullptr, edge_map);
+	if (graph.edge_slots != nullptr)
+		_fgn_slots_compact(graph.edge_slots, edge_map, old_edge_ct);
+
+	if (out_edge_remap == nullptr) free(edge_map);
+}
+void          _fgn_graph_compact   (fgn_graph_t &graph, const fgn_node_idx *node_map, const fgn_edge_idx *edge_map) {
+	// Survivors only ever move down, so everything compacts in place
+	int32_t edge_ct = 0;
+	for (int32_t i = 0; i < graph.edge_ct; i++) {
+		fgn_edge_t &e = graph.edges[i];
+		if (edge_map[i] == -1) {
+			_fgn_edge_data_free(graph, i);
+			continue;
+		}
+		if (node_map != nullptr) {
+			e.start = node_map[e.start];
+			e.end   = node_map[e.end];
+		}
+		if (graph.edge_structs.data != nullptr)
+			_fgn_structs_copy(graph.edge_structs, i, edge_ct);
+		graph.edges[edge_ct++] = e;
+	}
+	graph.edge_ct = edge_ct;
+
+	int32_t node_ct = 0;
 	for (int32_t i = 0; i < graph.node_ct; i++) {
 		fgn_node_t &n = graph.nodes[i];
-		for (int32_t e = 0; e < n.in_ct; e++) {
-			if (edge == n.in_edges[e]) {
-				_fgn_arr_remove(&n.in_edges, e, n.in_ct);
-				e--;
-			} else if (n.in_edges[e] > edge) {
-				n.in_edges[e]--;
-			}
+		if (node_map != nullptr && node_map[i] == -1) {
+			_fgn_node_data_free(graph, i);
+			_fgn_destroy(n, graph.mem);
+			continue;
 		}
+		int32_t ct = 0;
+		for (int32_t e = 0; e < graph.node_in_cts[i]; e++)
+			if (edge_map[n.in_edges[e]] != -1) n.in_edges[ct++] = edge_map[n.in_edges[e]];
+		graph.node_in_cts[i] = ct;
+		ct = 0;
+		for (int32_t e = 0; e < graph.node_out_cts[i]; e++)
+			if (edge_map[n.out_edges[e]] != -1) n.out_edges[ct++] = edge_map[n.out_edges[e]];
+		graph.node_out_cts[i] = ct;
+		graph.nodes[node_ct] = n;
+		_fgn_node_relink(graph.nodes[node_ct]);
+		_fgn_columns_copy(graph, i, node_ct);
+		if (graph.node_structs.data != nullptr)
+			_fgn_structs_copy(graph.node_structs, i, node_ct);
+		node_ct++;
+	}
 
-		for (int32_t e = 0; e < n.out_ct; e++) {
-			if (edge == n.out_edges[e]) {
-				_fgn_arr_remove(&n.out_edges, e, n.out_ct);
-				e--;
-			} else if (n.out_edges[e] > edge) {
-				n.out_edges[e]--;
-			}
+	if (node_ct != graph.node_ct) {
+		graph.node_ct = node_ct;
+		_fgn_index_build(graph);
+	}
+}
+
+///////////////////////////////////////////
+
+void          fgn_graph_use_handles (fgn_graph_t &graph) {
+	if (graph.node_slots != nullptr) return;
+	graph.node_slots = _fgn_slots_create(graph.node_ct);
+	graph.edge_slots = _fgn_slots_create(graph.edge_ct);
+}
+fgn_handle_t  fgn_graph_node_handle (const fgn_graph_t &graph, fgn_node_idx idx) {
+	assert(graph.node_slots != nullptr);
+	assert(idx >= 0 && idx < graph.node_ct);
+	return _fgn_slots_handle(graph.node_slots, idx);
+}
+fgn_node_idx  fgn_graph_node_resolve(const fgn_graph_t &graph, fgn_handle_t handle) {
+	assert(graph.node_slots != nullptr);
+	return _fgn_slots_resolve(graph.node_slots, handle);
+}
+fgn_handle_t  fgn_graph_edge_handle (const fgn_graph_t &graph, fgn_edge_idx idx) {
+	assert(graph.edge_slots != nullptr);
+	assert(idx >= 0 && idx < graph.edge_ct);
+	return _fgn_slots_handle(graph.edge_slots, idx);
+}
+fgn_edge_idx  fgn_graph_edge_resolve(const fgn_graph_t &graph, fgn_handle_t handle) {
+	assert(graph.edge_slots != nullptr);
+	return _fgn_slots_resolve(graph.edge_slots, handle);
+}
+
+///////////////////////////////////////////
+
+void fgn_graph_freeze(const fgn_graph_t &graph, fgn_frozen_t &frozen) {
+	int32_t node_ct = graph.node_ct;
+	int32_t edge_ct = graph.edge_ct;
+
+	// Offsets for both directions, then node and edge columns for both.
+	// Big graphs can go past what an int32_t holds here.
+	size_t size = ((size_t)node_ct + 1) * 2 + (size_t)edge_ct * 4;
+	if (size > frozen.mem_cap) {
+		free(frozen.mem);
+		frozen.mem     = (int32_t*)malloc(sizeof(int32_t) * size);
+		frozen.mem_cap = size;
+	}
+	frozen.node_ct   = node_ct;
+	frozen.edge_ct   = edge_ct;
+	frozen.out_start = frozen.mem;
+	frozen.in_start  = frozen.out_start + node_ct + 1;
+	frozen.out_nodes = frozen.in_start  + node_ct + 1;
+	frozen.out_edges = frozen.out_nodes + edge_ct;
+	frozen.in_nodes  = frozen.out_edges + edge_ct;
+	frozen.in_edges  = frozen.in_nodes  + edge_ct;
+
+	int32_t out_at = 0, in_at = 0;
+	for (int32_t n = 0; n < node_ct; n++) {
+		const fgn_node_t &node = graph.nodes[n];
+		frozen.out_start[n] = out_at;
+		frozen.in_start [n] = in_at;
+		for (int32_t i = 0; i < graph.node_out_cts[n]; i++) {
+			fgn_edge_idx e = node.out_edges[i];
+			frozen.out_edges[out_at] = e;
+			frozen.out_nodes[out_at] = graph.edges[e].end;
+			out_at++;
+		}
+		for (int32_t i = 0; i < graph.node_in_cts[n]; i++) {
+			fgn_edge_idx e = node.in_edges[i];
+			frozen.in_edges[in_at] = e;
+			frozen.in_nodes[in_at] = graph.edges[e].start;
+			in_at++;
 		}
 	}
+	frozen.out_start[node_ct] = out_at;
+	frozen.in_start [node_ct] = in_at;
+	assert(out_at == edge_ct && in_at == edge_ct);
+}
+
+///////////////////////////////////////////
+
+void fgn_destroy(fgn_frozen_t &frozen) {
+	free(frozen.mem);
+	frozen = {};
+}
+
+///////////////////////////////////////////
+
+_fgn_slots_t *_fgn_slots_create (int32_t count) {
+	_fgn_slots_t *result = (_fgn_slots_t *)calloc(1, sizeof(_fgn_slots_t));
+	result->free = -1;
+	for (int32_t i = 0; i < count; i++)
+		_fgn_slots_add(result, i);
+	return result;
+}
+void          _fgn_slots_destroy(_fgn_slots_t *slots) {
+	if (slots == nullptr) return;
+	free(slots->slots);
+	free(slots->slot_of);
+	free(slots);
+}
+void          _fgn_slots_add    (_fgn_slots_t *slots, int32_t idx) {
+	int32_t slot = slots->free;
+	if (slot != -1) {
+		slots->free = slots->slots[slot].idx;
+	} else {
+		slot = _fgn_arr_add(&slots->slots, 1, slots->slot_ct, slots->slot_cap);
+		slots->slots[slot].generation = 0;
+	}
+	slots->slots[slot].idx = idx;
+
+	// New items are always added at the end of the dense arrays
+	assert(idx == slots->slot_of_ct);
+	_fgn_arr_add(&slots->slot_of, 1, slots->slot_of_ct, slots->slot_of_cap);
+	slots->slot_of[idx] = slot;
+}
+void          _fgn_slots_remove (_fgn_slots_t *slots, int32_t idx, int32_t moved_from) {
+	int32_t slot = slots->slot_of[idx];
+	slots->slots[slot].generation += 1;
+	slots->slots[slot].idx         = slots->free;
+	slots->free                    = slot;
+
+	if (moved_from != -1) {
+		int32_t moved = slots->slot_of[moved_from];
+		slots->slots[moved].idx = idx;
+		slots->slot_of[idx]     = moved;
+	}
+	slots->slot_of_ct -= 1;
+}
+void          _fgn_slots_compact(_fgn_slots_t *slots, const int32_t *map, int32_t old_ct) {
+	int32_t ct = 0;
+	for (int32_t i = 0; i < old_ct; i++) {
+		int32_t slot = slots->slot_of[i];
+		if (map[i] == -1) {
+			slots->slots[slot].generation += 1;
+			slots->slots[slot].idx         = slots->free;
+			slots->free                    = slot;
+		} else {
+			slots->slots[slot].idx = map[i];
+			slots->slot_of[map[i]] = slot;
+			ct++;
+		}
+	}
+	slots->slot_of_ct = ct;
+}
+fgn_handle_t  _fgn_slots_handle (const _fgn_slots_t *slots, int32_t idx) {
+	if (slots == nullptr)
+		return { -1, 0 };
+	int32_t slot = slots->slot_of[idx];
+	return { slot, slots->slots[slot].generation };
+}
+int32_t       _fgn_slots_resolve(const _fgn_slots_t *slots, fgn_handle_t handle) {
+	if (slots == nullptr || handle.slot < 0 || handle.slot >= slots->slot_ct || slots->slots[handle.slot].generation != handle.generation)
+		return -1;
+	return slots->slots[handle.slot].idx;
 }
 
 ///////////////////////////////////////////
 
 void                    fgn_data_add    (fgn_data_t &data, const char *key, const char *value) {
-	int32_t i = _fgn_arr_add(&data.pairs, 1, data.pair_ct, data.pair_cap);
-	data.pairs[i].key      = _fgn_str_copy(key);
-	data.pairs[i].key_hash = _fgn_str_hash(key);
-	data.pairs[i].value    = _fgn_str_copy(value);
+	_fgn_mem_t *mem = _fgn_data_mem(data);
+	_fgn_data_add(data, mem, _fgn_mem_str(mem, key), _fgn_mem_value(mem, value));
+}
+void                    fgn_data_set_value(fgn_data_t &data, int32_t pair_idx, const char *value) {
+	assert(pair_idx >= 0 && pair_idx < data.pair_ct);
+	_fgn_mem_t *mem = _fgn_data_mem(data);
+	if (mem == nullptr)
+		free(data.pairs[pair_idx].value);
+	data.pairs[pair_idx].value = _fgn_mem_value(mem, value);
+}
+void                    _fgn_data_add   (fgn_data_t &data, _fgn_mem_t *mem, char *key, fgn_hash_t key_hash, char *value) {
+	// A negative capacity means the pairs, their strings and the parsed
+	// struct are borrowed from library memory. Blocks are never a mix of
+	// borrowed and owned, so strings get copied over to whichever side
+	// the block is already on.
+	if (mem != nullptr && data.pair_cap > 0) {
+		key   = _fgn_str_copy(key);
+		value = _fgn_str_copy(value);
+		mem   = nullptr;
+	} else if (mem == nullptr && data.pair_cap < 0) {
+		// Only heap strings get freed, interned keys belong to the library
+		mem = _fgn_data_mem(data);
+		char *heap_key = key, *heap_value = value;
+		if (!_fgn_mem_owns(_fgn_data_key_mem(data), heap_key)) {
+			key = _fgn_mem_str(mem, heap_key);
+			free(heap_key);
+		}
+		value = _fgn_mem_value(mem, heap_value);
+		free(heap_value);
+	}
+
+	// Lists grow with their head in front of them. Borrowed ones grow in
+	// the memory they came from, and store their capacity as ~cap.
+	int32_t i   = data.pair_ct;
+	int32_t cap = data.pair_cap < 0 ? ~data.pair_cap : data.pair_cap;
+	if (data.pair_ct + 1 > cap) {
+		int32_t            new_cap = cap * 2 > data.pair_ct + 1 ? cap * 2 : data.pair_ct + 2;
+		size_t             size    = sizeof(_fgn_pairs_head_t) + sizeof(_fgn_pair_t) * new_cap;
+		_fgn_pairs_head_t *head;
+		if (mem == nullptr) {
+			head = (_fgn_pairs_head_t *)realloc(_fgn_data_head(data), size);
+			if (data.pairs == nullptr) *head = {};
+			data.pair_cap = new_cap;
+		} else {
+			head = (_fgn_pairs_head_t *)_fgn_mem_alloc(mem, size);
+			if (data.pairs == nullptr) *head = {};
+			else                       *head = *_fgn_data_head(data);
+			if (data.pair_ct > 0)
+				memcpy(head + 1, data.pairs, sizeof(_fgn_pair_t) * data.pair_ct);
+			head->mem     = mem;
+			data.pair_cap = ~new_cap;
+		}
+		data.pairs = (_fgn_pair_t *)(head + 1);
+	}
+	data.pair_ct += 1;
+	data.pairs[i].key      = key;
+	data.pairs[i].key_hash = key_hash;
+	data.pairs[i].value    = value;
+
+	// Rather than growing the index, let the next lookup rebuild it
+	int32_t *index = _fgn_data_head(data)->index;
+	if (index != nullptr && index[0] > 0) {
+		if (data.pair_ct * 2 > index[0]) _fgn_data_index_drop(data);
+		else                             _fgn_data_index_add (data, i);
+	}
+}
+void                    _fgn_data_borrow(fgn_data_t &data, _fgn_mem_t *mem) {
+	// An empty borrowed block, so later edits know which memory to use
+	_fgn_pairs_head_t *head = (_fgn_pairs_head_t *)_fgn_mem_alloc(mem, sizeof(_fgn_pairs_head_t));
+	*head = { mem, nullptr, nullptr };
+	data.pairs    = (_fgn_pair_t *)(head + 1);
+	data.pair_ct  = 0;
+	data.pair_cap = ~0;
+}
+_fgn_mem_t             *_fgn_data_mem   (const fgn_data_t &data) {
+	return data.pair_cap < 0 ? _fgn_data_head(data)->mem : nullptr;
+}
+void                   *_fgn_data_alloc (fgn_data_t &data, size_t size) {
+	_fgn_mem_t *mem    = _fgn_data_mem(data);
+	void       *result = mem == nullptr ? malloc(size) : _fgn_mem_alloc(mem, size);
+	memset(result, 0, size);
+	return result;
 }
 void                    fgn_data_destroy(fgn_data_t &data) {
+	_fgn_data_destroy(data, _fgn_data_key_mem(data));
+}
+void                    _fgn_data_destroy(fgn_data_t &data, const _fgn_mem_t *mem) {
+	// Borrowed blocks just get emptied, and keep their memory around
+	if (data.pair_cap < 0) {
+		data.pair_ct = 0;
+		data.data    = nullptr;
+		_fgn_data_index_drop(data);
+		return;
+	}
+
+	// Keys from a load are interned in library memory, and shared
 	for (int32_t i = 0; i < data.pair_ct; i++) {
-		free(data.pairs[i].key);
+		if (!_fgn_mem_owns(mem, data.pairs[i].key))
+			free(data.pairs[i].key);
+		free(data.pairs[i].value);
+	}
+	if (data.pairs != nullptr)
+		free(_fgn_data_head(data)->index);
+	free(_fgn_data_head(data));
+	free(data.data);
+	data = {};
+}
+
+fgn_hash_t              fgn_hash        (const char *key) {
+	return _fgn_str_hash(key);
+}
+int32_t                 fgn_data_find   (fgn_data_t &data, const char *key) {
+	return fgn_data_find_hash(data, key, _fgn_str_hash(key));
+}
+int32_t                 fgn_data_find_hash(fgn_data_t &data, const char *key, fgn_hash_t key_hash) {
+	if (data.pair_ct <= _FGN_DATA_INDEX_MIN) {
+		for (int32_t i = 0; i < data.pair_ct; i++) {
+			if (data.pairs[i].key_hash == key_hash && strcmp(data.pairs[i].key, key) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	_fgn_pairs_head_t *head = _fgn_data_head(data);
+	if (head->index == nullptr || head->index[0] < 0)
+		_fgn_data_index_build(data);
+	int32_t  cap   = head->index[0];
+	int32_t *slots = head->index + 1;
+	int32_t  slot  = _fgn_index_slot(key_hash, cap);
+	while (slots[slot] != 0) {
+		const _fgn_pair_t &pair = data.pairs[slots[slot] - 1];
+		if (pair.key_hash == key_hash && strcmp(pair.key, key) == 0)
+			return slots[slot] - 1;
+		slot = (slot + 1) & (cap - 1);
+	}
+	return -1;
+}
+const char             *fgn_data_value  (fgn_data_t &data, const char *key) {
+	int32_t i = fgn_data_find(data, key);
+	return i == -1 ? nullptr : data.pairs[i].value;
+}
+void                    fgn_data_set    (fgn_data_t &data, const char *key, const char *value) {
+	int32_t i = fgn_data_find(data, key);
+	if (i == -1) fgn_data_add      (data, key, value);
+	else         fgn_data_set_value(data, i,   value);
+}
+bool                    fgn_data_remove (fgn_data_t &data, const char *key) {
+	int32_t i = fgn_data_find(data, key);
+	if (i == -1)
+		return false;
+
+	// Borrowed strings stay in library memory, as do interned keys
+	if (data.pair_cap > 0) {
+		if (!_fgn_mem_owns(_fgn_data_key_mem(data), data.pairs[i].key))
+			free(data.pairs[i].key);
 		free(data.pairs[i].value);
 	}
-	free(data.pairs);
-	data = {};
+	memmove(&data.pairs[i], &data.pairs[i + 1], sizeof(_fgn_pair_t) * (data.pair_ct - i - 1));
+	data.pair_ct -= 1;
+	_fgn_data_index_drop(data);
+	return true;
+}
+
+void                    _fgn_data_index_build(fgn_data_t &data) {
+	// At most half full, the capacity is always a power of 2
+	int32_t cap = 16;
+	while (cap < data.pair_ct * 2)
+		cap *= 2;
+
+	// Library memory isn't freed until the library is, so a stale index
+	// on a borrowed list gets reused whenever it's still big enough.
+	_fgn_pairs_head_t *head = _fgn_data_head(data);
+	if (head->index != nullptr && ~head->index[0] >= cap) {
+		cap = ~head->index[0];
+		memset(head->index + 1, 0, sizeof(int32_t) * cap);
+	} else {
+		head->index = (int32_t *)_fgn_data_alloc(data, sizeof(int32_t) * (cap + 1));
+	}
+	head->index[0] = cap;
+	for (int32_t i = 0; i < data.pair_ct; i++)
+		_fgn_data_index_add(data, i);
+}
+void                    _fgn_data_index_add  (fgn_data_t &data, int32_t pair_idx) {
+	int32_t           *index = _fgn_data_head(data)->index;
+	int32_t            cap   = index[0];
+	int32_t           *slots = index + 1;
+	const _fgn_pair_t &pair  = data.pairs[pair_idx];
+	int32_t            slot  = _fgn_index_slot(pair.key_hash, cap);
+	while (slots[slot] != 0) {
+		// Duplicate keys keep pointing at the first pair
+		const _fgn_pair_t &first = data.pairs[slots[slot] - 1];
+		if (first.key_hash == pair.key_hash && strcmp(first.key, pair.key) == 0)
+			return;
+		slot = (slot + 1) & (cap - 1);
+	}
+	slots[slot] = pair_idx + 1;
+}
+void                    _fgn_data_index_drop (fgn_data_t &data) {
+	// Borrowed blocks got their index from library memory, and mark it
+	// stale rather than lose track of it
+	_fgn_pairs_head_t *head = _fgn_data_head(data);
+	if (head == nullptr) return;
+	if (data.pair_cap > 0) {
+		free(head->index);
+		head->index = nullptr;
+	} else if (head->index != nullptr && head->index[0] > 0) {
+		head->index[0] = ~head->index[0];
+	}
 }
 
 ///////////////////////////////////////////
 
-void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset,
-	bool  (*parse)(fgn_parse_state_t state, const char *value_text, void *out_data),
-	char *(*write)(fgn_parse_state_t state, void *value)) {
+void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset, fgn_parse_fn parse, fgn_write_str_fn write) {
+	fgn_parser_add(parser, name, offset, parse, (fgn_write_fn)nullptr);
+	parser.items[parser.item_ct - 1].write_str = write;
+}
+void fgn_parser_add(fgn_parser_t &parser, const char *name, int32_t offset, fgn_parse_fn parse, fgn_write_fn write) {
 	int32_t i = _fgn_arr_add(&parser.items, 1, parser.item_ct, parser.item_cap);
-	parser.items[i].key      = name;
-	parser.items[i].key_hash = _fgn_str_hash(name);
-	parser.items[i].offset   = offset;
-	parser.items[i].parse    = parse;
-	parser.items[i].write    = write;
+	parser.items[i].key       = name;
+	parser.items[i].key_hash  = _fgn_str_hash(name);
+	parser.items[i].offset    = offset;
+	parser.items[i].parse     = parse;
+	parser.items[i].write     = write;
+	parser.items[i].write_str = nullptr;
+	// Generated parse and write functions wouldn't know about this item
+	parser.parse_pairs        = nullptr;
+	parser.write_struct       = nullptr;
+
+	// Rebuild the lookup table when it gets too full, the capacity is
+	// always a power of 2. Duplicate keys keep pointing at the first item.
+	int32_t first = i;
+	if (parser.item_ct * 2 > parser.lookup_cap) {
+		free(parser.lookup);
+		parser.lookup_cap = parser.lookup_cap == 0 ? 16 : parser.lookup_cap * 2;
+		parser.lookup     = (int32_t *)calloc(parser.lookup_cap, sizeof(int32_t));
+		first = 0;
+	}
+	for (; first < parser.item_ct; first++) {
+		fgn_hash_t hash = parser.items[first].key_hash;
+		int32_t    slot = _fgn_index_slot(hash, parser.lookup_cap);
+		while (parser.lookup[slot] != 0 && parser.items[parser.lookup[slot] - 1].key_hash != hash)
+			slot = (slot + 1) & (parser.lookup_cap - 1);
+		if (parser.lookup[slot] == 0)
+			parser.lookup[slot] = first + 1;
+	}
+}
+int32_t _fgn_parser_find(const fgn_parser_t &parser, fgn_hash_t key_hash) {
+	if (parser.lookup_cap == 0)
+		return -1;
+	int32_t slot = _fgn_index_slot(key_hash, parser.lookup_cap);
+	while (parser.lookup[slot] != 0) {
+		if (parser.items[parser.lookup[slot] - 1].key_hash == key_hash)
+			return parser.lookup[slot] - 1;
+		slot = (slot + 1) & (parser.lookup_cap - 1);
+	}
+	return -1;
 }
 
-void _fgn_parse(const fgn_parser_t &parser, fgn_parse_state_t state, fgn_data_t &data) {
-	data.data = malloc(parser.type_size);
-	memset(data.data, 0, parser.type_size);
+void _fgn_parse(const fgn_parser_t &parser, fgn_parse_state_t state, fgn_data_t &data, void *out_struct) {
+	// Nodes and edges parse into the graph's struct arrays, which replace
+	// any struct they had of their own
+	if (out_struct == nullptr) {
+		out_struct = data.data = _fgn_data_alloc(data, parser.type_size);
+	} else if (data.data != nullptr) {
+		if (data.pair_cap >= 0)
+			free(data.data);
+		data.data = nullptr;
+	}
+	_fgn_data_index_drop(data);
 
-	// Parse as many key/value pairs as possible!
-	int32_t parsed = 0;
-	for (int32_t i = 0; i < data.pair_ct; i++) {
-		for (size_t p = 0; p < parser.item_ct; p++) {
-			if (data.pairs[i].key_hash == parser.items[p].key_hash) {
-				if (parser.items[p].parse(state, data.pairs[i].value, ((uint8_t *)data.data) + parser.items[p].offset)) {
-					free(data.pairs[i].key);
-					free(data.pairs[i].value);
-					data.pairs[i].key = nullptr;
-					parsed += 1;
-				}
-				break;
+	// Parse as many key/value pairs as possible! Parsed pairs are
+	// dropped, and the rest slide down to fill the gaps.
+	if (parser.parse_pairs != nullptr) {
+		data.pair_ct = parser.parse_pairs(state, data, out_struct);
+	} else {
+		int32_t ct = 0;
+		for (int32_t i = 0; i < data.pair_ct; i++) {
+			int32_t p = _fgn_parser_find(parser, data.pairs[i].key_hash);
+			if (p != -1 && parser.items[p].parse(state, data.pairs[i].value, ((uint8_t *)out_struct) + parser.items[p].offset)) {
+				if (data.pair_cap > 0)
+					_fgn_pair_free(state.graph, data, i);
+				continue;
 			}
+			data.pairs[ct++] = data.pairs[i];
 		}
+		data.pair_ct = ct;
 	}
 
-	// Remove the parsed pairs from the list by creating a new list!
-	_fgn_pair_t *old_pairs = data.pairs;
-	int32_t     old_count = data.pair_ct;
-	data.pair_cap = old_count - parsed;
-	data.pair_ct  = 0;
-	data.pairs    = nullptr;
-	if (data.pair_cap > 0) {
-		data.pairs = (_fgn_pair_t *)malloc(sizeof(_fgn_pair_t) * data.pair_cap);
-		for (int32_t i = 0; i < old_count; i++) {
-			if (old_pairs[i].key != nullptr) {
-				data.pairs[data.pair_ct] = old_pairs[i];
-				data.pair_ct += 1;
+	// Owned lists that end up empty don't need to hang on to memory
+	if (data.pair_cap > 0 && data.pair_ct == 0) {
+		free(_fgn_data_head(data));
+		data.pairs    = nullptr;
+		data.pair_cap = 0;
+	}
+}
+void _fgn_pair_free(const fgn_graph_t &graph, const fgn_data_t &data, int32_t pair_idx) {
+	if (!_fgn_mem_owns(graph.mem, data.pairs[pair_idx].key))
+		free(data.pairs[pair_idx].key);
+	free(data.pairs[pair_idx].value);
+}
+void _fgn_parse_graphs(fgn_graph_t *graphs, int32_t graph_ct, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph, int32_t thread_ct) {
+	struct range_t {
+		int32_t graph;
+		int32_t start, end;
+		bool    edges;
+	};
+	const int32_t range_size = 4096;
+	range_t      *ranges     = nullptr;
+	int32_t       range_ct   = 0, range_cap = 0;
+
+	// Anything that allocates from shared memory happens up front: graph
+	// data, and the struct arrays. After that every node and edge only
+	// touches its own pairs and struct, so ranges can go in any order.
+	for (int32_t g = 0; g < graph_ct; g++) {
+		fgn_graph_t &graph = graphs[g];
+		if (parser_graph != nullptr)
+			_fgn_parse(*parser_graph, { graph, -1, -1 }, graph.data, nullptr);
+		if (parser_node != nullptr) {
+			_fgn_structs_use(graph, false, (int32_t)parser_node->type_size, true);
+			for (int32_t i = 0; i < graph.node_ct; i += range_size) {
+				int32_t r = _fgn_arr_add(&ranges, 1, range_ct, range_cap);
+				ranges[r] = { g, i, i + range_size < graph.node_ct ? i + range_size : graph.node_ct, false };
+			}
+		}
+		if (parser_edge != nullptr) {
+			_fgn_structs_use(graph, true, (int32_t)parser_edge->type_size, true);
+			for (int32_t i = 0; i < graph.edge_ct; i += range_size) {
+				int32_t r = _fgn_arr_add(&ranges, 1, range_ct, range_cap);
+				ranges[r] = { g, i, i + range_size < graph.edge_ct ? i + range_size : graph.edge_ct, true };
 			}
 		}
 	}
-	free(old_pairs);
-}
-void fgn_parse  (fgn_graph_t   &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph ) {
-	fgn_parse_state_t state = { graph, -1, -1 };
 
-	// Parse the graph's data
-	if (parser_graph != nullptr)
-		_fgn_parse(*parser_graph, state, graph.data);
+	// Lazy graphs still have their parsed flags here, and anything that
+	// was already parsed on access keeps its struct as it is.
+	auto parse_range = [&](const range_t &range) {
+		fgn_graph_t          &graph   = graphs[range.graph];
+		const _fgn_structs_t &structs = range.edges ? graph.edge_structs : graph.node_structs;
+		fgn_parse_state_t     state   = { graph, -1, -1 };
+		for (int32_t i = range.start; i < range.end; i++) {
+			if (structs.parsed != nullptr && structs.parsed[i])
+				continue;
+			void *out_struct = structs.data + (size_t)i * structs.size;
+			if (range.edges) {
+				state.curr_edge = i;
+				if (graph.edges[i].data_ref != 0)
+					_fgn_parse(*parser_edge, state, graph.edge_data[graph.edges[i].data_ref - 1], out_struct);
+			} else {
+				state.curr_node = i;
+				if (graph.nodes[i].data_ref != 0)
+					_fgn_parse(*parser_node, state, graph.node_data[graph.nodes[i].data_ref - 1], out_struct);
+			}
+		}
+	};
 
-	// Parse node data
-	if (parser_node != nullptr) {
-		for (int32_t i = 0; i < graph.node_ct; i++) {
-			state.curr_node = i;
-			_fgn_parse(*parser_node, state, graph.nodes[i].data);
+	if (thread_ct <= 0)
+		thread_ct = (int32_t)std::thread::hardware_concurrency();
+	if (thread_ct > range_ct)
+		thread_ct = range_ct;
+	if (thread_ct <= 1) {
+		for (int32_t r = 0; r < range_ct; r++)
+			parse_range(ranges[r]);
+	} else {
+		// Each thread grabs the next range as soon as it's done
+		std::thread     *threads = new std::thread[thread_ct];
+		std::atomic<int> next_range(0);
+		for (int32_t t = 0; t < thread_ct; t++) {
+			threads[t] = std::thread([&]() {
+				for (int32_t r = next_range++; r < range_ct; r = next_range++)
+					parse_range(ranges[r]);
+			});
 		}
+		for (int32_t t = 0; t < thread_ct; t++)
+			threads[t].join();
+		delete [] threads;
 	}
-	state.curr_node = -1;
+	free(ranges);
 
-	// Parse edge data
-	if (parser_edge != nullptr) {
-		for (int32_t i = 0; i < graph.edge_ct; i++) {
-			state.curr_edge = i;
-			_fgn_parse(*parser_edge, state, graph.edges[i].data);
-		}
+	for (int32_t g = 0; g < graph_ct; g++) {
+		if (parser_node != nullptr) _fgn_structs_eager(graphs[g].node_structs);
+		if (parser_edge != nullptr) _fgn_structs_eager(graphs[g].edge_structs);
 	}
 }
-void fgn_parse  (fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
-	for (int32_t i = 0; i < lib.graph_ct; i++) {
-		fgn_parse(lib.graphs[i], parser_node, parser_edge, parser_graph);
-	}
+void fgn_parse  (fgn_graph_t   &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph, int32_t thread_ct) {
+	_fgn_parse_graphs(&graph, 1, parser_node, parser_edge, parser_graph, thread_ct);
+}
+void fgn_parse  (fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph, int32_t thread_ct) {
+	_fgn_parse_graphs(lib.graphs, lib.graph_ct, parser_node, parser_edge, parser_graph, thread_ct);
+}
+void _fgn_parse_lazy(fgn_graph_t &graph, bool edges, const fgn_parser_t *parser) {
+	if (parser == nullptr) return;
+	_fgn_structs_use(graph, edges, (int32_t)parser->type_size, true);
+	_fgn_structs_t &structs = edges ? graph.edge_structs : graph.node_structs;
+	structs.parser = parser;
+	if (structs.parsed == nullptr)
+		structs.parsed = (uint8_t *)calloc(structs.cap, 1);
+}
+void fgn_parse_lazy(fgn_graph_t   &graph, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	if (parser_graph != nullptr)
+		_fgn_parse(*parser_graph, { graph, -1, -1 }, graph.data, nullptr);
+	_fgn_parse_lazy(graph, false, parser_node);
+	_fgn_parse_lazy(graph, true,  parser_edge);
+}
+void fgn_parse_lazy(fgn_library_t &lib, const fgn_parser_t *parser_node, const fgn_parser_t *parser_edge, const fgn_parser_t *parser_graph) {
+	for (int32_t i = 0; i < lib.graph_ct; i++)
+		fgn_parse_lazy(lib.graphs[i], parser_node, parser_edge, parser_graph);
 }
 void fgn_destroy(fgn_parser_t  &parser) {
 	free(parser.items);
+	free(parser.lookup);
 	parser = {};
 }
 
 ///////////////////////////////////////////
 
-bool  fgn_parse_float (fgn_parse_state_t state, const char *value_text, void *out_data) {
-	*((float*)out_data) = atof(value_text);
+// Hands back a write function's result, copying it to out if it fits
+int32_t _fgn_write_result(char *out, int32_t out_size, const char *text, int32_t length) {
+	if (length <= out_size)
+		memcpy(out, text, length);
+	return length;
+}
+
+bool    fgn_parse_float (fgn_parse_state_t state, const char *value_text, void *out_data) {
+	*((float*)out_data) = _fgn_float_parse(value_text);
 	return true;
 }
-char *fgn_write_float (fgn_parse_state_t state, void *value) {
-	if (*(float *)value == 0) return nullptr;
-	return _fgn_str_make("%g", *(float*)value);
+int32_t fgn_write_float (fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (*(float *)value == 0) return -1;
+	char text[32];
+	return _fgn_write_result(out, out_size, text, _fgn_float_write(*(float*)value, text));
 }
-bool  fgn_parse_float2(fgn_parse_state_t state, const char *value_text, void *out_data) {
-	((float*)out_data)[0] = atof(value_text);
-	((float*)out_data)[1] = atof(_fgn_str_next_word(value_text,','));
+bool    fgn_parse_float2(fgn_parse_state_t state, const char *value_text, void *out_data) {
+	((float*)out_data)[0] = _fgn_float_parse(value_text);
+	((float*)out_data)[1] = _fgn_float_parse(_fgn_str_next_word(value_text,','));
 	return true;
 }
-char *fgn_write_float2(fgn_parse_state_t state,void *value) {
-	if (((float *)value)[0] == 0 && ((float *)value)[1] == 0) return nullptr;
-	return _fgn_str_make("%g, %g", ((float*)value)[0], ((float*)value)[1]);
+int32_t fgn_write_float2(fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (((float *)value)[0] == 0 && ((float *)value)[1] == 0) return -1;
+	char    text[64];
+	int32_t ct = _fgn_float_write(((float*)value)[0], text);
+	text[ct++] = ','; text[ct++] = ' ';
+	ct += _fgn_float_write(((float*)value)[1], text + ct);
+	return _fgn_write_result(out, out_size, text, ct);
 }
-bool  fgn_parse_float3(fgn_parse_state_t state, const char *value_text, void *out_data) {
-	((float*)out_data)[0] = atof(value_text);
+bool    fgn_parse_float3(fgn_parse_state_t state, const char *value_text, void *out_data) {
+	((float*)out_data)[0] = _fgn_float_parse(value_text);
 	value_text = _fgn_str_next_word(value_text, ',');
-	((float*)out_data)[1] = atof(value_text);
+	((float*)out_data)[1] = _fgn_float_parse(value_text);
 	value_text = _fgn_str_next_word(value_text, ',');
-	((float*)out_data)[2] = atof(value_text);
+	((float*)out_data)[2] = _fgn_float_parse(value_text);
 	return true;
 }
-char *fgn_write_float3(fgn_parse_state_t state, void *value) {
-	if (((float *)value)[0] == 0 && ((float *)value)[1] == 0 && ((float *)value)[2] == 0) return nullptr;
-	return _fgn_str_make("%g, %g, %g", ((float*)value)[0], ((float*)value)[1], ((float*)value)[2]);
+int32_t fgn_write_float3(fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (((float *)value)[0] == 0 && ((float *)value)[1] == 0 && ((float *)value)[2] == 0) return -1;
+	char    text[96];
+	int32_t ct = _fgn_float_write(((float*)value)[0], text);
+	text[ct++] = ','; text[ct++] = ' ';
+	ct += _fgn_float_write(((float*)value)[1], text + ct);
+	text[ct++] = ','; text[ct++] = ' ';
+	ct += _fgn_float_write(((float*)value)[2], text + ct);
+	return _fgn_write_result(out, out_size, text, ct);
 }
-bool  fgn_parse_int32 (fgn_parse_state_t state, const char *value_text, void *out_data) {
-	*((int32_t*)out_data) = atoi(value_text);
+bool    fgn_parse_int32 (fgn_parse_state_t state, const char *value_text, void *out_data) {
+	*((int32_t*)out_data) = _fgn_int_parse(value_text);
 	return true;
 }
-char *fgn_write_int32 (fgn_parse_state_t state, void *value) {
-	if (*(int *)value == 0) return nullptr;
-	return _fgn_str_make("%d", *(int*)value);
+int32_t fgn_write_int32 (fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (*(int *)value == 0) return -1;
+	char text[16];
+	return _fgn_write_result(out, out_size, text, _fgn_int_write(*(int32_t*)value, text));
 }
-bool  fgn_parse_string(fgn_parse_state_t state, const char *value_text, void *out_data) {
+bool    fgn_parse_string(fgn_parse_state_t state, const char *value_text, void *out_data) {
 	*((char**)out_data) = _fgn_str_copy(value_text);
 	return true;
 }
-char *fgn_write_string(fgn_parse_state_t state, void *value) {
-	if (*(char **)value == nullptr) return nullptr;
-	return _fgn_str_copy(*(char **)value);
+int32_t fgn_write_string(fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (*(char **)value == nullptr) return -1;
+	return _fgn_write_result(out, out_size, *(char **)value, (int32_t)strlen(*(char **)value));
 }
-bool  fgn_parse_nodeid(fgn_parse_state_t state, const char *value_text, void *out_data) {
+bool    fgn_parse_nodeid(fgn_parse_state_t state, const char *value_text, void *out_data) {
 	*((fgn_node_idx*)out_data) = fgn_graph_node_findid(state.graph, value_text);
 	return *((fgn_node_idx *)out_data) != -1;
 }
-char *fgn_write_nodeid(fgn_parse_state_t state, void *value) {
-	if (*(fgn_node_idx *)value == -1) return nullptr;
-	return _fgn_str_copy(fgn_graph_node_get(state.graph, *(fgn_node_idx*)value).id);
+int32_t fgn_write_nodeid(fgn_parse_state_t state, void *value, char *out, int32_t out_size) {
+	if (*(fgn_node_idx *)value == -1) return -1;
+	const char *id = fgn_graph_node_get(state.graph, *(fgn_node_idx*)value).id;
+	return _fgn_write_result(out, out_size, id, (int32_t)strlen(id));
 }
 
 ///////////////////////////////////////////
@@ -869,46 +3087,445 @@ bool        _fgn_str_eq    (const char *a, const char *b) {
 	}
 	return *a == *b;
 }
-bool        _fgn_str_starts(const char *a, const char *b) {
-	while (*a != '\0' && *b != '\0') {
-		if (*a != *b)
-			return false;
-		a++;
-		b++;
-	}
-	return *b == '\0';
-}
 fgn_hash_t  _fgn_str_hash  (const char *string) {
+	return _fgn_str_hash_n(string, strlen(string));
+}
+fgn_hash_t  _fgn_str_hash_n(const char *string, size_t length) {
 	// FNV-1a hash (64bit): http://isthe.com/chongo/tech/comp/fnv/
-	uint64_t hash = 14695981039346656037;
-	uint8_t  c;
-	while (c = *string++)
-		hash = (hash ^ c) * 1099511628211;
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)string[i]) * 1099511628211ULL;
 	return hash;
 }
 char       *_fgn_str_copy  (const char *string) {
-	size_t len = strlen(string);
+	return _fgn_str_copy_n(string, strlen(string));
+}
+char       *_fgn_str_copy_n(const char *string, size_t len) {
 	char *result = (char*)malloc(len + 1); 
 	memcpy(result, string, len); 
 	result[len] = '\0'; 
 	return result; 
 }
-void        _fgn_str_append(char **string, int32_t &count, int32_t &cap, const char *text, ...) {
-	va_list argptr;
-	va_start(argptr, text);
-	size_t length = vsnprintf(nullptr, 0, text, argptr);
-	int32_t start = _fgn_arr_add(string, length, count, cap);
-	vsnprintf((*string)+start, length+1, text, argptr);
-	va_end(argptr);
-}
-char       *_fgn_str_make  (const char *text, ...) {
-	va_list argptr;
-	va_start(argptr, text);
-	size_t length = vsnprintf(nullptr, 0, text, argptr);
-	char *result = (char*)malloc(length+1);
-	vsnprintf(result, length+1, text, argptr);
-	va_end(argptr);
-	return result;
+void        _fgn_out_flush  (_fgn_out_t &out) {
+	if (out.fp == nullptr || out.ct == 0) return;
+	fwrite(out.text, out.ct, 1, out.fp);
+	out.ct = 0;
+}
+void        _fgn_out_reserve(_fgn_out_t &out, size_t length) {
+	if (out.ct + length <= out.cap) return;
+
+	// File output just flushes, string output grows
+	if (out.fp != nullptr) {
+		_fgn_out_flush(out);
+		return;
+	}
+	size_t cap = out.cap == 0 ? 1024 : out.cap;
+	while (out.ct + length > cap)
+		cap *= 2;
+	out.text = (char*)realloc(out.text, cap);
+	out.cap  = cap;
+}
+void        _fgn_out_str    (_fgn_out_t &out, const char *str, size_t length) {
+	if (out.ct + length <= out.cap) {
+		memcpy(out.text + out.ct, str, length);
+		out.ct += length;
+		return;
+	}
+	// Strings longer than a file buffer go out in buffer sized pieces
+	while (out.fp != nullptr && out.ct + length > out.cap) {
+		size_t part = out.cap - out.ct;
+		memcpy(out.text + out.ct, str, part);
+		out.ct += part;
+		_fgn_out_flush(out);
+		str    += part;
+		length -= part;
+	}
+	_fgn_out_reserve(out, length);
+	memcpy(out.text + out.ct, str, length);
+	out.ct += length;
+}
+void        _fgn_out_value  (_fgn_out_t &out, const char *str) {
+	// Values with line breaks or quotes get wrapped in quotes, and any
+	// quotes inside become \' with \ doubled up.
+	size_t plain = strcspn(str, "\n\"");
+	if (str[plain] == '\0') {
+		_fgn_out_str(out, str, plain);
+		return;
+	}
+	_fgn_out_str(out, "\"", 1);
+	if (strchr(str + plain, '"') == nullptr) {
+		_fgn_out_str(out, str, plain + strlen(str + plain));
+	} else {
+		while (*str != '\0') {
+			size_t length = strcspn(str, "\"\\");
+			_fgn_out_str(out, str, length);
+			str += length;
+			if      (*str == '"' ) { _fgn_out_str(out, "\\'",  2); str++; }
+			else if (*str == '\\') { _fgn_out_str(out, "\\\\", 2); str++; }
+		}
+	}
+	_fgn_out_str(out, "\"", 1);
+}
+void        _fgn_out_float  (_fgn_out_t &out, float value) {
+	char text[32];
+	_fgn_out_str(out, text, _fgn_float_write(value, text));
+}
+void        _fgn_out_item   (_fgn_out_t &out, fgn_parse_state_t state, const _fgn_parse_item_t &item, void *value) {
+	size_t  key_len = strlen(item.key);
+	int32_t room;
+	char   *at      = _fgn_out_item_begin(out, key_len, room);
+	int32_t length  = item.write(state, value, at, room);
+	_fgn_out_item_end(out, state, item.key, key_len, item.write, value, length, room);
+}
+char       *_fgn_out_item_begin(_fgn_out_t &out, size_t key_len, int32_t &room) {
+	// The value gets written straight into the buffer, just past where
+	// its key goes, so nothing is committed until we know it's there.
+	size_t prefix = key_len + 2;
+	_fgn_out_reserve(out, prefix + 64);
+	room = out.ct + prefix < out.cap ? (int32_t)(out.cap - out.ct - prefix) : 0;
+	return out.text + out.ct + prefix;
+}
+void        _fgn_out_item_end  (_fgn_out_t &out, fgn_parse_state_t state, const char *key, size_t key_len, fgn_write_fn write, void *value, int32_t length, int32_t room) {
+	size_t prefix = key_len + 2;
+	auto   space  = [&out, prefix]() { return out.ct + prefix < out.cap ? (int32_t)(out.cap - out.ct - prefix) : 0; };
+	if (length < 0) return;
+	if (length + 1 > room) {
+		if (out.fp != nullptr) _fgn_out_flush(out);
+		_fgn_out_reserve(out, prefix + length + 1);
+		room = space();
+		// File buffers don't grow, so huge values go through a copy
+		if (length + 1 > room) {
+			char *text = (char *)malloc(length + 1);
+			write(state, value, text, length);
+			text[length] = '\0';
+			_fgn_out_str  (out, "\t", 1);
+			_fgn_out_str  (out, key, key_len);
+			_fgn_out_str  (out, " ", 1);
+			_fgn_out_value(out, text);
+			_fgn_out_str  (out, "\n", 1);
+			free(text);
+			return;
+		}
+		write(state, value, out.text + out.ct + prefix, room);
+	}
+
+	char *at = out.text + out.ct;
+	if (memchr(at + prefix, '\n', length) == nullptr && memchr(at + prefix, '"', length) == nullptr) {
+		at[0] = '\t';
+		memcpy(at + 1, key, key_len);
+		at[prefix - 1]      = ' ';
+		at[prefix + length] = '\n';
+		out.ct += prefix + length + 1;
+		return;
+	}
+	// Values that need quoting are rare, so they can take the slow way
+	char *text = _fgn_str_copy_n(at + prefix, length);
+	_fgn_out_str  (out, "\t", 1);
+	_fgn_out_str  (out, key, key_len);
+	_fgn_out_str  (out, " ", 1);
+	_fgn_out_value(out, text);
+	_fgn_out_str  (out, "\n", 1);
+	free(text);
+}
+
+///////////////////////////////////////////
+
+const double _fgn_pow10[23] = { 1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22 };
+
+// Powers of 10 up to 22 are exact doubles, past that it takes a few
+// roundings. Floats only need ~25 of the 53 bits, so that's plenty.
+double _fgn_scale10(double value, int32_t exp10) {
+	while (exp10 >  22) { value *= 1e22; exp10 -= 22; }
+	while (exp10 < -22) { value /= 1e22; exp10 += 22; }
+	return exp10 < 0 ? value / _fgn_pow10[-exp10] : value * _fgn_pow10[exp10];
+}
+
+// Just enough of a big integer to settle the rare decimal that lands
+// right on the halfway point between two floats.
+struct _fgn_bignum_t {
+	uint32_t limbs[128];
+	int32_t  ct;
+};
+void _fgn_bignum_mul(_fgn_bignum_t &num, uint32_t mul, uint32_t add) {
+	uint64_t carry = add;
+	for (int32_t i = 0; i < num.ct; i++) {
+		carry += (uint64_t)num.limbs[i] * mul;
+		num.limbs[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+	if (carry != 0 && num.ct < 128)
+		num.limbs[num.ct++] = (uint32_t)carry;
+}
+void _fgn_bignum_pow10(_fgn_bignum_t &num, int32_t exp10) {
+	for (; exp10 >= 9; exp10 -= 9) _fgn_bignum_mul(num, 1000000000, 0);
+	if (exp10 > 0)                  _fgn_bignum_mul(num, (uint32_t)_fgn_pow10[exp10], 0);
+}
+void _fgn_bignum_pow2(_fgn_bignum_t &num, int32_t exp2) {
+	for (; exp2 >= 31; exp2 -= 31) _fgn_bignum_mul(num, 1u << 31, 0);
+	if (exp2 > 0)                  _fgn_bignum_mul(num, 1u << exp2, 0);
+}
+int32_t _fgn_bignum_cmp(const _fgn_bignum_t &a, const _fgn_bignum_t &b) {
+	if (a.ct != b.ct) return a.ct < b.ct ? -1 : 1;
+	for (int32_t i = a.ct - 1; i >= 0; i--) {
+		if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+// Exactly compares the decimal digits at text with the float halfway
+// point mid, returns -1, 0 or 1 like strcmp.
+int32_t _fgn_float_cmp_mid(const char *text, double mid) {
+	_fgn_bignum_t value = {}, half = {};
+	int32_t exp10  = 0;
+	int32_t digits = 0;
+	bool    point  = false, sticky = false;
+	for (; (*text >= '0' && *text <= '9') || (*text == '.' && !point); text++) {
+		if (*text == '.') { point = true; continue; }
+		if (digits == 0 && *text == '0') { if (point) exp10--; continue; }
+		// Digits past this many can only nudge the value off a tie
+		if (digits >= 760) {
+			if (*text != '0') sticky = true;
+			if (!point) exp10++;
+			continue;
+		}
+		_fgn_bignum_mul(value, 10, *text - '0');
+		digits++;
+		if (point) exp10--;
+	}
+	if ((*text == 'e' || *text == 'E') && ((text[1] >= '0' && text[1] <= '9') || ((text[1] == '-' || text[1] == '+') && text[2] >= '0' && text[2] <= '9'))) {
+		bool    negative = text[1] == '-';
+		int32_t exp      = 0;
+		for (text += (text[1] == '-' || text[1] == '+') ? 2 : 1; *text >= '0' && *text <= '9'; text++)
+			if (exp < 100000) exp = exp * 10 + (*text - '0');
+		exp10 += negative ? -exp : exp;
+	}
+
+	int32_t  exp2;
+	uint64_t mantissa = (uint64_t)ldexp(frexp(mid, &exp2), 53);
+	exp2 -= 53;
+	half.limbs[0] = (uint32_t)mantissa;
+	half.limbs[1] = (uint32_t)(mantissa >> 32);
+	half.ct       = half.limbs[1] != 0 ? 2 : 1;
+
+	if (exp10 > 0) _fgn_bignum_pow10(value, exp10); else _fgn_bignum_pow10(half, -exp10);
+	if (exp2  > 0) _fgn_bignum_pow2 (half,  exp2 ); else _fgn_bignum_pow2 (value, -exp2 );
+	int32_t result = _fgn_bignum_cmp(value, half);
+	return result == 0 && sticky ? 1 : result;
+}
+
+float _fgn_float_parse(const char *text) {
+	while (*text == ' ' || *text == '\t') text++;
+	bool negative = *text == '-';
+	if (*text == '-' || *text == '+') text++;
+
+	// inf and nan, as printf writes them
+	if ((text[0] | 0x20) == 'i' && (text[1] | 0x20) == 'n' && (text[2] | 0x20) == 'f') return negative ? -INFINITY : INFINITY;
+	if ((text[0] | 0x20) == 'n' && (text[1] | 0x20) == 'a' && (text[2] | 0x20) == 'n') return negative ? -NAN : NAN;
+
+	// Gather up to 19 significant digits, which fit in 64 bits
+	const char *start     = text;
+	uint64_t    mantissa  = 0;
+	int32_t     digits    = 0;
+	int32_t     exp10     = 0;
+	bool        point     = false;
+	bool        truncated = false;
+	for (; (*text >= '0' && *text <= '9') || (*text == '.' && !point); text++) {
+		if (*text == '.') { point = true; continue; }
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*text - '0');
+			if (mantissa != 0) digits++;
+			if (point) exp10--;
+		} else {
+			if (*text != '0') truncated = true;
+			if (!point) exp10++;
+		}
+	}
+	if ((*text == 'e' || *text == 'E') && ((text[1] >= '0' && text[1] <= '9') || ((text[1] == '-' || text[1] == '+') && text[2] >= '0' && text[2] <= '9'))) {
+		bool    exp_negative = text[1] == '-';
+		int32_t exp          = 0;
+		for (text += (text[1] == '-' || text[1] == '+') ? 2 : 1; *text >= '0' && *text <= '9'; text++)
+			if (exp < 100000) exp = exp * 10 + (*text - '0');
+		exp10 += exp_negative ? -exp : exp;
+	}
+
+	float result;
+	if      (mantissa == 0)          result = 0;
+	else if (digits + exp10 > 39)    result = INFINITY;
+	else if (digits + exp10 < -45)   result = 0;
+	else if (!truncated && mantissa <= (1 << 24) && exp10 >= -10 && exp10 <= 10) {
+		// Both are exact floats, so one float operation rounds correctly
+		result = exp10 < 0
+			? (float)mantissa / (float)_fgn_pow10[-exp10]
+			: (float)mantissa * (float)_fgn_pow10[ exp10];
+	} else {
+		// The double is within a few of its own ulps of the real value,
+		// which only matters if it's that close to halfway between floats.
+		double   approx = _fgn_scale10((double)mantissa, exp10);
+		uint64_t bits;
+		memcpy(&bits, &approx, sizeof(bits));
+		int32_t  exp2 = (int32_t)(bits >> 52) - 1023;
+		int32_t  drop = 29 + (exp2 < -126 ? -126 - exp2 : 0);
+		uint64_t rem  = drop < 53 ? bits & ((1ull << drop) - 1) : 0;
+		uint64_t half = drop < 53 ? 1ull << (drop - 1)          : 0;
+		result = (float)approx;
+		if (drop >= 53 || (rem + 8 >= half && rem <= half + 8)) {
+			float lo = result, hi = result;
+			if (result == INFINITY)           lo = FLT_MAX;
+			else if ((double)result <= approx) hi = nextafterf(result, INFINITY);
+			else                               lo = nextafterf(result, 0);
+			double mid = hi == INFINITY
+				? (double)FLT_MAX + ldexp(1.0, 103)
+				: ((double)lo + (double)hi) * 0.5;
+
+			uint32_t lo_bits;
+			memcpy(&lo_bits, &lo, sizeof(lo_bits));
+			int32_t cmp = _fgn_float_cmp_mid(start, mid);
+			result = cmp > 0 || (cmp == 0 && (lo_bits & 1)) ? hi : lo;
+		}
+	}
+	return negative ? -result : result;
+}
+
+int32_t _fgn_float_write(float value, char *out_text) {
+	char *curr = out_text;
+	if (signbit(value)) { *curr++ = '-'; value = -value; }
+	if (value != value)      { memcpy(curr, "nan", 4); return (int32_t)(curr - out_text) + 3; }
+	if (value == INFINITY)   { memcpy(curr, "inf", 4); return (int32_t)(curr - out_text) + 3; }
+	if (value == 0)          { memcpy(curr, "0",   2); return (int32_t)(curr - out_text) + 1; }
+
+	// Anything in the range between the halfway points to the
+	// neighboring floats parses back to this float. Ties go to even.
+	uint32_t bits, prev_bits, next_bits;
+	memcpy(&bits, &value, sizeof(bits));
+	prev_bits = bits - 1;
+	next_bits = bits + 1;
+	float  prev, next;
+	memcpy(&prev, &prev_bits, sizeof(prev));
+	memcpy(&next, &next_bits, sizeof(next));
+	double x  = value;
+	double lo = (x + (double)prev) * 0.5;
+	double hi = next == INFINITY ? x + ldexp(1.0, 103) : (x + (double)next) * 0.5;
+
+	// Scale everything so the value has 9 digits before the point, the
+	// binary exponent gives a close enough guess at the decimal one.
+	int32_t exp2 = (int32_t)(bits >> 23) - 127;
+	if (exp2 == -127) {
+		frexp(x, &exp2);
+		exp2 -= 1;
+	}
+	int32_t exp10 = (exp2 * 78913) >> 18;
+	double  x9    = _fgn_scale10(x, 8 - exp10);
+	if      (x9 >= 1e9) { exp10++; x9 = _fgn_scale10(x, 8 - exp10); }
+	else if (x9 <  1e8) { exp10--; x9 = _fgn_scale10(x, 8 - exp10); }
+	double  lo9   = _fgn_scale10(lo, 8 - exp10);
+	double  hi9   = _fgn_scale10(hi, 8 - exp10);
+	int32_t shift = exp10 - 8;
+
+	// Finds the candidate with this many digits closest to the value,
+	// or 0 if none of them land inside the range.
+	auto candidate = [&](int32_t precision) -> uint64_t {
+		double unit = _fgn_pow10[9 - precision];
+		double lo_s = lo9 / unit;
+		double hi_s = hi9 / unit;
+		double n    = floor(x9 / unit + 0.5);
+		if (n > hi_s) n = floor(hi_s);
+		if (n < lo_s) n = ceil (lo_s);
+		double margin = n * 1e-12;
+		if (n < lo_s - margin || n > hi_s + margin) return 0;
+		if (fabs(n - lo_s) > margin && fabs(n - hi_s) > margin) return (uint64_t)(n * unit);
+
+		// Too close to the edge of the range to trust the doubles, so
+		// check it against the parser, which is exact.
+		char    check[32];
+		int32_t ct = _fgn_int_write((int32_t)n, check);
+		check[ct++] = 'e';
+		_fgn_int_write(shift + 9 - precision, check + ct);
+		float    parsed = _fgn_float_parse(check);
+		uint32_t parsed_bits;
+		memcpy(&parsed_bits, &parsed, sizeof(parsed_bits));
+		return parsed_bits == bits ? (uint64_t)(n * unit) : 0;
+	};
+
+	// If some precision works, every higher one does too, so we can
+	// binary search for the fewest digits. 9 digits always works.
+	uint64_t digits = (uint64_t)floor(x9 + 0.5);
+	int32_t  min    = 1, max = 9;
+	while (min < max) {
+		int32_t  mid    = (min + max) / 2;
+		uint64_t result = candidate(mid);
+		if (result != 0) { digits = result; max = mid;     }
+		else             {                   min = mid + 1; }
+	}
+
+	// Turn the digits into text, dropping trailing zeros
+	char    text[24];
+	int32_t ct = 0;
+	for (; digits > 0; digits /= 10)
+		text[ct++] = '0' + (char)(digits % 10);
+	int32_t first = 0;
+	while (first < ct - 1 && text[first] == '0') first++;
+	int32_t count = ct - first;
+	exp10 = shift + ct - 1;
+	for (int32_t i = 0; i < count / 2; i++) {
+		char t = text[first + i]; text[first + i] = text[ct - 1 - i]; text[ct - 1 - i] = t;
+	}
+	const char *d = text + first;
+
+	// Same choice between plain and exponent notation as %g, with the
+	// precision stretched to however many digits we need.
+	if (exp10 >= -4 && exp10 < (count > 6 ? count : 6)) {
+		if (exp10 < 0) {
+			*curr++ = '0'; *curr++ = '.';
+			for (int32_t i = -1; i > exp10; i--) *curr++ = '0';
+			memcpy(curr, d, count); curr += count;
+		} else if (count <= exp10 + 1) {
+			memcpy(curr, d, count); curr += count;
+			for (int32_t i = count; i <= exp10; i++) *curr++ = '0';
+		} else {
+			memcpy(curr, d, exp10 + 1); curr += exp10 + 1;
+			*curr++ = '.';
+			memcpy(curr, d + exp10 + 1, count - exp10 - 1); curr += count - exp10 - 1;
+		}
+	} else {
+		*curr++ = d[0];
+		if (count > 1) {
+			*curr++ = '.';
+			memcpy(curr, d + 1, count - 1); curr += count - 1;
+		}
+		*curr++ = 'e';
+		*curr++ = exp10 < 0 ? '-' : '+';
+		int32_t exp = exp10 < 0 ? -exp10 : exp10;
+		if (exp < 10) *curr++ = '0';
+		curr += _fgn_int_write(exp, curr);
+	}
+	*curr = '\0';
+	return (int32_t)(curr - out_text);
+}
+
+int32_t _fgn_int_write(int32_t value, char *out_text) {
+	char    *curr = out_text;
+	uint32_t abs  = (uint32_t)value;
+	if (value < 0) { *curr++ = '-'; abs = 0u - abs; }
+
+	char    text[10];
+	int32_t ct = 0;
+	do {
+		text[ct++] = '0' + (char)(abs % 10);
+		abs /= 10;
+	} while (abs > 0);
+	while (ct > 0) *curr++ = text[--ct];
+	*curr = '\0';
+	return (int32_t)(curr - out_text);
+}
+int32_t _fgn_int_parse(const char *text) {
+	while (*text == ' ' || *text == '\t') text++;
+	bool negative = *text == '-';
+	if (*text == '-' || *text == '+') text++;
+
+	uint32_t result = 0;
+	for (; *text >= '0' && *text <= '9'; text++)
+		result = result * 10 + (*text - '0');
+	return (int32_t)(negative ? 0u - result : result);
 }
 
 ///////////////////////////////////////////
@@ -918,14 +3535,6 @@ const char *_fgn_str_trim     (const char *str) {
 		str++; 
 	return str; 
 }
-const char *_fgn_str_next_line(const char *str)           { 
-	bool q = false; 
-	while (*str != '\0' && (q || (*str != '\n' && *str != '\r'               ))) { 
-		if (*str == '"') q = !q; 
-		str++; 
-	} 
-	return str; 
-}
 const char *_fgn_str_next_word(const char *str, char sep) { 
 	bool q = false; 
 	while (*str != '\0' && (q || (*str != '\n' && *str != '\r' && *str != sep))) { 
@@ -935,77 +3544,117 @@ const char *_fgn_str_next_word(const char *str, char sep) {
 	if (*str == sep) str++; 
 	return _fgn_str_trim(str);
 }
-char       *_fgn_str_copy_line(const char *str) { 
-	const char *end = _fgn_str_next_line(str); 
-	char *result = (char*)malloc((end - str) + 1); 
-	memcpy(result, str, end - str); 
-	result[end - str] = '\0'; 
-	return result;
-}
-char       *_fgn_str_copy_word(const char *str, char sep) { 
-	const char *end = str;
-	bool q = false; 
-	while (*end != '\0' && (q || (*end != '\n' && *end != '\r' && *end != sep))) { 
-		if (*end == '"') q = !q; 
-		end++; 
-	}
-	char *result = (char*)malloc((end - str) + 1); 
-	memcpy(result, str, end - str); 
-	result[end - str] = '\0'; 
-	return result; 
+
+inline int32_t _fgn_ctz32(uint32_t x) {
+#if defined(_MSC_VER)
+	unsigned long result; _BitScanForward(&result, x); return (int32_t)result;
+#else
+	return __builtin_ctz(x);
+#endif
 }
-bool        _fgn_str_line_has (const char *str, char sep) {
-	bool q = false; 
-	while (*str != '\0' && (q || (*str != '\n' && *str != '\r'))) { 
-		if (*str == '"') q = !q;
-		if (*str == sep) return true;
-		str++; 
-	} 
-	return false;
+inline int32_t _fgn_msb32(uint32_t x) {
+#if defined(_MSC_VER)
+	unsigned long result; _BitScanReverse(&result, x); return (int32_t)result;
+#else
+	return 31 - __builtin_clz(x);
+#endif
 }
-bool        _fgn_str_contains (const char *str, char sep) {
-	while (*str != '\0') { 
-		if (*str == sep) return true;
-		str++;
-	} 
-	return false;
+#if defined(_FGN_SIMD_AVX2) || defined(_FGN_SIMD_SSE2)
+// Bit masks for 32 characters at a time, one bit per character
+struct _fgn_block_t { uint32_t newline, zero, space, colon, comma, quote; };
+_FGN_NO_SANITIZE inline void _fgn_scan_block(const char *block, _fgn_block_t &out) {
+#if defined(_FGN_SIMD_AVX2)
+	__m256i chars = _mm256_load_si256((const __m256i *)block);
+	#define _FGN_EQ(c) ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c))))
+#else
+	__m128i lo = _mm_load_si128((const __m128i *)block);
+	__m128i hi = _mm_load_si128((const __m128i *)(block + 16));
+	#define _FGN_EQ(c) ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lo, _mm_set1_epi8(c))) | ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(hi, _mm_set1_epi8(c))) << 16))
+#endif
+	out.newline = _FGN_EQ('\n') | _FGN_EQ('\r');
+	out.zero    = _FGN_EQ('\0');
+	out.space   = _FGN_EQ(' ');
+	out.colon   = _FGN_EQ(':');
+	out.comma   = _FGN_EQ(',');
+	out.quote   = _FGN_EQ('"');
+	#undef _FGN_EQ
 }
-char       *_fgn_str_escape   (const char *str) {
-	if (_fgn_str_contains(str, '\n') || _fgn_str_contains(str, '"')) {
-		if (_fgn_str_contains(str, '"')) {
-			int32_t len = (int32_t)strlen(str);
-			// Count the number of quotes in the text
-			int count = 0;
-			for (int32_t i = 0; i < len; i++) {
-				if (str[i] == '"' || str[i] == '\\')
-					count++;
+#endif
+_FGN_NO_SANITIZE void _fgn_scan_line(const char *str, const char *range_start, const char *range_end, _fgn_line_t &line) {
+	line = {};
+	int32_t comma_ct = 0;
+	bool    q        = false;
+	auto scan_char = [&](const char *c) {
+		if (c == range_end || *c == '\0' || (!q && (*c == '\n' || *c == '\r'))) { line.end = c; return true; }
+		if      (*c == '"') { q = !q; line.last_quote = c; }
+		else if (q)         return false;
+		else if (*c == ' ' && line.space == nullptr) line.space = c;
+		else if (*c == ':' && line.colon == nullptr) line.colon = c;
+		else if (*c == ',' && comma_ct < 2)          line.comma[comma_ct++] = c;
+		return false;
+	};
+
+	const char *at = str;
+#if defined(_FGN_SIMD_AVX2) || defined(_FGN_SIMD_SSE2)
+	// Work on aligned 32 byte blocks, and mask off anything in the first
+	// block that comes before the start of the string. Blocks have to fit
+	// inside [range_start, range_end), in parallel loads another thread
+	// may be writing to the bytes past either side, so the partial blocks
+	// at the edges go one character at a time.
+	const char *block = (const char *)((uintptr_t)str & ~(uintptr_t)31);
+	if (block < range_start) {
+		block += 32;
+		while (at < block && !scan_char(at)) at++;
+	}
+	if (line.end == nullptr) {
+		uint32_t valid  = ~0u << (uint32_t)(at - block);
+		uint32_t inside = q ? ~0u : 0; // All 1s if the previous block ended inside quotes
+		for (; range_end == nullptr || block + 32 <= range_end; block += 32, valid = ~0u) {
+			_fgn_block_t b;
+			_fgn_scan_block(block, b);
+
+			// Prefix xor of the quote bits gives us which characters are
+			// inside of quotes, carried over from the previous block.
+			uint32_t quote  = b.quote & valid;
+			uint32_t in_q   = quote;
+			in_q ^= in_q << 1; in_q ^= in_q << 2; in_q ^= in_q << 4; in_q ^= in_q << 8; in_q ^= in_q << 16;
+			in_q ^= inside;
+			inside = (uint32_t)((int32_t)in_q >> 31);
+
+			uint32_t out    = ~in_q & valid;
+			uint32_t stop   = (b.newline & out) | (b.zero & valid);
+			uint32_t before = stop == 0 ? ~0u : (stop & (0u - stop)) - 1;
+
+			uint32_t space = b.space & out & before;
+			uint32_t colon = b.colon & out & before;
+			uint32_t comma = b.comma & out & before;
+			quote &= before;
+			if (line.space == nullptr && space != 0) line.space = block + _fgn_ctz32(space);
+			if (line.colon == nullptr && colon != 0) line.colon = block + _fgn_ctz32(colon);
+			while (comma_ct < 2 && comma != 0) {
+				line.comma[comma_ct++] = block + _fgn_ctz32(comma);
+				comma &= comma - 1;
 			}
-			// Replace the quotes with \' and any \ with \\ 
-			char *result = (char*)malloc(len + 2 + count * 2);
-			int   curr   = 1;
-			result[0] = '"';
-			for (int32_t i = 0; i < len; i++) {
-				if (str[i] == '\\') {
-					result[curr] = '\\'; curr++;
-					result[curr] = '\\'; curr++;
-				} else if (str[i] == '"') {
-					result[curr] = '\\'; curr++;
-					result[curr] = '\''; curr++;
-				} else {
-					result[curr] = str[i];
-					curr++;
-				}
+			if (quote != 0) line.last_quote = block + _fgn_msb32(quote);
+
+			if (stop != 0) {
+				line.end = block + _fgn_ctz32(stop);
+				break;
 			}
-			// Finish it off with a quote and a terminating character
-			result[curr] = '"'; curr++;
-			result[curr] = '\0';
-			return result;
-		} else {
-			return _fgn_str_make("\"%s\"", str);
 		}
+		// Ran into range_end, pick up from the last whole block
+		q = inside != 0;
+		if (block > at) at = block;
 	}
-	return nullptr;
+#endif
+	if (line.end == nullptr)
+		while (!scan_char(at)) at++;
+	if (line.space    == nullptr) line.space    = line.end;
+	if (line.colon    == nullptr) line.colon    = line.end;
+	if (line.comma[0] == nullptr) line.comma[0] = line.end;
+	if (line.comma[1] == nullptr) line.comma[1] = line.end;
 }
+
 void        _fgn_str_unescape (char *str) {
 	char *curr   = str;
 	char *write  = str;
@@ -1045,5 +3694,422 @@ template<typename T> void    _fgn_arr_remove(T **arr, int32_t index, int32_t &co
 	count -= 1;
 }
 
+///////////////////////////////////////////
+
+inline int32_t _fgn_index_slot(fgn_hash_t hash, int32_t cap) {
+	return (int32_t)((hash ^ (hash >> 32)) & (fgn_hash_t)(cap - 1));
+}
+void         _fgn_index_build (fgn_graph_t &graph) {
+	// Keep the table at most half full, the capacity is always a power of 2
+	free(graph.node_index);
+	graph.node_index_cap = graph.node_index_cap == 0 ? 16 : graph.node_index_cap;
+	while ((graph.node_ct + 1) * 2 > graph.node_index_cap)
+		graph.node_index_cap *= 2;
+	graph.node_index = (fgn_node_idx *)calloc(graph.node_index_cap, sizeof(fgn_node_idx));
+
+	for (fgn_node_idx i = 0; i < graph.node_ct; i++) {
+		if (graph.nodes[i].id == nullptr) continue;
+		int32_t slot = _fgn_index_slot(graph.node_hashes[i], graph.node_index_cap);
+		while (graph.node_index[slot] != 0)
+			slot = (slot + 1) & (graph.node_index_cap - 1);
+		graph.node_index[slot] = i + 1;
+	}
+}
+void         _fgn_index_add   (fgn_graph_t &graph, fgn_node_idx idx) {
+	// Growing re-inserts everything, including the node we're adding
+	if ((graph.node_ct + 1) * 2 > graph.node_index_cap) {
+		_fgn_index_build(graph);
+		return;
+	}
+
+	int32_t slot = _fgn_index_slot(graph.node_hashes[idx], graph.node_index_cap);
+	while (graph.node_index[slot] != 0)
+		slot = (slot + 1) & (graph.node_index_cap - 1);
+	graph.node_index[slot] = idx + 1;
+}
+void         _fgn_index_remove(fgn_graph_t &graph, fgn_node_idx idx) {
+	if (graph.node_index_cap == 0) return;
+	int32_t mask = graph.node_index_cap - 1;
+	int32_t slot = _fgn_index_slot(graph.node_hashes[idx], graph.node_index_cap);
+	while (graph.node_index[slot] != idx + 1) {
+		if (graph.node_index[slot] == 0) return;
+		slot = (slot + 1) & mask;
+	}
+
+	// Backward shift deletion, so we don't need tombstones: pull any
+	// following entries that probed past this slot back into it.
+	int32_t hole = slot;
+	int32_t curr = (slot + 1) & mask;
+	while (graph.node_index[curr] != 0) {
+		int32_t home = _fgn_index_slot(graph.node_hashes[graph.node_index[curr] - 1], graph.node_index_cap);
+		if (((curr - home) & mask) >= ((curr - hole) & mask)) {
+			graph.node_index[hole] = graph.node_index[curr];
+			hole = curr;
+		}
+		curr = (curr + 1) & mask;
+	}
+	graph.node_index[hole] = 0;
+}
+void         _fgn_index_move  (fgn_graph_t &graph, fgn_node_idx from, fgn_node_idx to) {
+	// The node at index from now lives at to, hashes are the same
+	int32_t slot = _fgn_index_slot(graph.node_hashes[to], graph.node_index_cap);
+	while (graph.node_index[slot] != from + 1)
+		slot = (slot + 1) & (graph.node_index_cap - 1);
+	graph.node_index[slot] = to + 1;
+}
+fgn_node_idx _fgn_index_find  (const fgn_graph_t &graph, fgn_hash_t hash, const char *id, size_t id_len) {
+	if (graph.node_index_cap == 0) return -1;
+	int32_t slot = _fgn_index_slot(hash, graph.node_index_cap);
+	while (graph.node_index[slot] != 0) {
+		// Only nodes with a matching hash get their id compared
+		fgn_node_idx idx = graph.node_index[slot] - 1;
+		if (hash == graph.node_hashes[idx] && memcmp(id, graph.nodes[idx].id, id_len) == 0 && graph.nodes[idx].id[id_len] == '\0')
+			return idx;
+		slot = (slot + 1) & (graph.node_index_cap - 1);
+	}
+	return -1;
+}
+
+///////////////////////////////////////////
+
+void _fgn_columns_grow  (fgn_graph_t &graph, int32_t count) {
+	if (count <= graph.node_column_cap) return;
+	graph.node_column_cap = graph.node_column_cap * 2 > count ? graph.node_column_cap * 2 : count;
+	graph.node_hashes     = (fgn_hash_t *)realloc(graph.node_hashes,    sizeof(fgn_hash_t) * graph.node_column_cap);
+	graph.node_positions  = (float      *)realloc(graph.node_positions, sizeof(float) * 3  * graph.node_column_cap);
+	graph.node_in_cts     = (int32_t    *)realloc(graph.node_in_cts,    sizeof(int32_t)    * graph.node_column_cap);
+	graph.node_out_cts    = (int32_t    *)realloc(graph.node_out_cts,   sizeof(int32_t)    * graph.node_column_cap);
+}
+void _fgn_columns_copy  (fgn_graph_t &graph, fgn_node_idx from, fgn_node_idx to) {
+	graph.node_hashes [to] = graph.node_hashes [from];
+	graph.node_in_cts [to] = graph.node_in_cts [from];
+	graph.node_out_cts[to] = graph.node_out_cts[from];
+	memcpy(&graph.node_positions[to * 3], &graph.node_positions[from * 3], sizeof(float) * 3);
+}
+void _fgn_columns_remove(fgn_graph_t &graph, fgn_node_idx idx) {
+	// Called after node_ct has already dropped by one
+	int32_t after = graph.node_ct - idx;
+	memmove(&graph.node_hashes   [idx],     &graph.node_hashes   [idx + 1],       sizeof(fgn_hash_t) * after);
+	memmove(&graph.node_positions[idx * 3], &graph.node_positions[(idx + 1) * 3], sizeof(float) * 3  * after);
+	memmove(&graph.node_in_cts   [idx],     &graph.node_in_cts   [idx + 1],       sizeof(int32_t)    * after);
+	memmove(&graph.node_out_cts  [idx],     &graph.node_out_cts  [idx + 1],       sizeof(int32_t)    * after);
+}
+
+///////////////////////////////////////////
+
+bool _fgn_structs_use(fgn_graph_t &graph, bool edges, int32_t size, bool clear) {
+	_fgn_structs_t &structs = edges ? graph.edge_structs : graph.node_structs;
+	int32_t         count   = edges ? graph.edge_ct      : graph.node_ct;
+
+	// Parsing can switch to a different struct, anything else should be
+	// asking for the same one every time.
+	if (!clear && structs.size != 0 && structs.size != size)
+		return false;
+	bool fresh = structs.size != size;
+	// Lazy structs parsed on access so far are kept, along with their
+	// parsed flags, so the parse this is for can skip over them.
+	if (clear && !fresh && structs.parsed != nullptr) {
+		_fgn_structs_grow(structs, count > 0 ? count : 1);
+		return true;
+	}
+	if (clear)
+		_fgn_structs_eager(structs);
+	if (fresh) {
+		free(structs.data);
+		structs.size = size;
+		structs.cap  = count > 0 ? count : 1;
+		structs.data = (uint8_t *)calloc(structs.cap, size);
+	} else if (clear) {
+		_fgn_structs_grow(structs, count > 0 ? count : 1);
+		memset(structs.data, 0, (size_t)size * count);
+	}
+
+	// Structs that were allocated one at a time move into the array.
+	// Parsing replaces them instead, and drops them as it goes.
+	if (clear || !fresh) return true;
+	for (int32_t i = 0; i < count; i++) {
+		int32_t     data_ref = edges ? graph.edges[i].data_ref : graph.nodes[i].data_ref;
+		fgn_data_t *data     = data_ref == 0 ? nullptr : edges ? &graph.edge_data[data_ref - 1] : &graph.node_data[data_ref - 1];
+		if (data == nullptr || data->data == nullptr) continue;
+		memcpy(structs.data + (size_t)i * size, data->data, size);
+		if (data->pair_cap >= 0)
+			free(data->data);
+		data->data = nullptr;
+	}
+	return true;
+}
+void _fgn_structs_grow(_fgn_structs_t &structs, int32_t count) {
+	if (count <= structs.cap) return;
+	structs.cap  = structs.cap * 2 > count ? structs.cap * 2 : count;
+	structs.data = (uint8_t *)realloc(structs.data, (size_t)structs.size * structs.cap);
+	if (structs.parsed != nullptr)
+		structs.parsed = (uint8_t *)realloc(structs.parsed, structs.cap);
+}
+void _fgn_structs_add(_fgn_structs_t &structs, int32_t idx) {
+	_fgn_structs_grow(structs, idx + 1);
+	memset(structs.data + (size_t)idx * structs.size, 0, structs.size);
+	// New ones parse on first access too, in case pairs get added first
+	if (structs.parsed != nullptr)
+		structs.parsed[idx] = 0;
+}
+void _fgn_structs_copy(_fgn_structs_t &structs, int32_t from, int32_t to) {
+	if (from == to) return;
+	memcpy(structs.data + (size_t)to * structs.size, structs.data + (size_t)from * structs.size, structs.size);
+	if (structs.parsed != nullptr)
+		structs.parsed[to] = structs.parsed[from];
+}
+void _fgn_structs_remove(_fgn_structs_t &structs, int32_t idx, int32_t count) {
+	// count is how many there are after the removal
+	memmove(structs.data + (size_t)idx * structs.size, structs.data + (size_t)(idx + 1) * structs.size, (size_t)structs.size * (count - idx));
+	if (structs.parsed != nullptr)
+		memmove(structs.parsed + idx, structs.parsed + idx + 1, count - idx);
+}
+void _fgn_structs_eager(_fgn_structs_t &structs) {
+	free(structs.parsed);
+	structs.parsed = nullptr;
+	structs.parser = nullptr;
+}
+void _fgn_structs_parse(fgn_graph_t &graph, bool edges, int32_t idx) {
+	_fgn_structs_t   &structs = edges ? graph.edge_structs : graph.node_structs;
+	fgn_parse_state_t state   = { graph, edges ? -1 : idx, edges ? idx : -1 };
+	if (idx >= (edges ? graph.edge_ct : graph.node_ct)) return;
+
+	structs.parsed[idx] = 1;
+	void *out_struct = structs.data + (size_t)idx * structs.size;
+	int32_t data_ref = edges ? graph.edges[idx].data_ref : graph.nodes[idx].data_ref;
+	if (data_ref != 0)
+		_fgn_parse(*structs.parser, state, edges ? graph.edge_data[data_ref - 1] : graph.node_data[data_ref - 1], out_struct);
+}
+void _fgn_structs_parse_all(fgn_graph_t &graph, bool edges) {
+	_fgn_structs_t &structs = edges ? graph.edge_structs : graph.node_structs;
+	if (structs.parsed == nullptr) return;
+	int32_t count = edges ? graph.edge_ct : graph.node_ct;
+	for (int32_t i = 0; i < count; i++) {
+		if (!structs.parsed[i])
+			_fgn_structs_parse(graph, edges, i);
+	}
+	_fgn_structs_eager(structs);
+}
+
+///////////////////////////////////////////
+
+_fgn_mem_t *_fgn_mem_create () {
+	_fgn_mem_t *result = (_fgn_mem_t *)calloc(1, sizeof(_fgn_mem_t));
+	result->chunk_size = 64 * 1024;
+	return result;
+}
+_fgn_mem_t *_fgn_mem_create_child(_fgn_mem_t *parent) {
+	_fgn_mem_t *result = _fgn_mem_create();
+	result->arena        = parent->arena;
+	result->share_values = parent->share_values;
+	result->chunk_size   = parent->chunk_size;
+	int32_t i = _fgn_arr_add(&parent->children, 1, parent->child_ct, parent->child_cap);
+	parent->children[i] = result;
+	return result;
+}
+void        _fgn_mem_region_free(_fgn_mem_region_t &region) {
+	if (!region.mapped)    free(region.start);
+#if defined(_WIN32)
+	else                   UnmapViewOfFile(region.start);
+#else
+	else                   munmap(region.start, region.size);
+#endif
+}
+void        _fgn_mem_destroy(_fgn_mem_t *mem) {
+	if (mem == nullptr) return;
+	for (int32_t i = 0; i < mem->child_ct; i++)
+		_fgn_mem_destroy(mem->children[i]);
+	free(mem->children);
+	free(mem->interned);
+	for (int32_t i = 0; i < mem->region_ct; i++)
+		_fgn_mem_region_free(mem->regions[i]);
+	free(mem->regions);
+	free(mem);
+}
+void       *_fgn_mem_alloc  (_fgn_mem_t *mem, size_t size) {
+	size = (size + 7) & ~(size_t)7;
+
+	// Allocate out of the most recent chunk if there's room for it
+	for (int32_t i = mem->region_ct - 1; i >= 0; i--) {
+		_fgn_mem_region_t &region = mem->regions[i];
+		if (region.mapped) continue;
+		if (region.size - region.used >= size) {
+			void *result = region.start + region.used;
+			region.used += size;
+			return result;
+		}
+		break;
+	}
+
+	// Otherwise, make a new chunk. Chunks double in size as we go so
+	// there's only ever a handful of them to search through.
+	while (mem->chunk_size < size)
+		mem->chunk_size *= 2;
+	int32_t i = _fgn_arr_add(&mem->regions, 1, mem->region_ct, mem->region_cap);
+	_fgn_mem_region_t &region = mem->regions[i];
+	region.start = (uint8_t *)malloc(mem->chunk_size);
+	region.size  = mem->chunk_size;
+	region.used  = size;
+	mem->chunk_size *= 2;
+	return region.start;
+}
+char       *_fgn_mem_str    (_fgn_mem_t *mem, const char *string) {
+	return _fgn_mem_str_n(mem, string, strlen(string));
+}
+char       *_fgn_mem_str_n  (_fgn_mem_t *mem, const char *string, size_t length) {
+	if (mem == nullptr)
+		return _fgn_str_copy_n(string, length);
+	char *result = (char *)_fgn_mem_alloc(mem, length + 1);
+	memcpy(result, string, length);
+	result[length] = '\0';
+	return result;
+}
+char       *_fgn_mem_intern (_fgn_mem_t *mem, const char *string, size_t length, fgn_hash_t hash) {
+	if ((mem->interned_ct + 1) * 2 > mem->interned_cap) {
+		_fgn_interned_t *old     = mem->interned;
+		int32_t          old_cap = mem->interned_cap;
+		mem->interned_cap = old_cap == 0 ? 64 : old_cap * 2;
+		mem->interned     = (_fgn_interned_t *)calloc(mem->interned_cap, sizeof(_fgn_interned_t));
+		for (int32_t i = 0; i < old_cap; i++) {
+			if (old[i].string == nullptr) continue;
+			int32_t slot = _fgn_index_slot(old[i].hash, mem->interned_cap);
+			while (mem->interned[slot].string != nullptr)
+				slot = (slot + 1) & (mem->interned_cap - 1);
+			mem->interned[slot] = old[i];
+		}
+		free(old);
+	}
+
+	int32_t slot = _fgn_index_slot(hash, mem->interned_cap);
+	while (mem->interned[slot].string != nullptr) {
+		const _fgn_interned_t &entry = mem->interned[slot];
+		if (entry.hash == hash && memcmp(entry.string, string, length) == 0 && entry.string[length] == '\0')
+			return entry.string;
+		slot = (slot + 1) & (mem->interned_cap - 1);
+	}
+	mem->interned[slot].hash   = hash;
+	mem->interned[slot].string = _fgn_mem_str_n(mem, string, length);
+	mem->interned_ct += 1;
+	return mem->interned[slot].string;
+}
+char       *_fgn_mem_value  (_fgn_mem_t *mem, const char *string) {
+	size_t length = strlen(string);
+	return mem != nullptr && mem->share_values
+		? _fgn_mem_intern(mem, string, length, _fgn_str_hash_n(string, length))
+		: _fgn_mem_str_n (mem, string, length);
+}
+bool        _fgn_mem_owns   (const _fgn_mem_t *mem, const void *ptr) {
+	if (mem == nullptr) return false;
+	for (int32_t i = 0; i < mem->region_ct; i++) {
+		const _fgn_mem_region_t &region = mem->regions[i];
+		if ((const uint8_t *)ptr >= region.start && (const uint8_t *)ptr < region.start + region.size)
+			return true;
+	}
+	for (int32_t i = 0; i < mem->child_ct; i++) {
+		if (_fgn_mem_owns(mem->children[i], ptr))
+			return true;
+	}
+	return false;
+}
+char       *_fgn_mem_map_file(_fgn_mem_t *mem, const char *filename, size_t *out_size) {
+	// Map the file copy-on-write, so strings can be terminated in-place
+	// without touching the file itself. The byte after the end of the
+	// file needs to be a readable '\0' for the parser, which is only
+	// guaranteed if the file doesn't end exactly on a page boundary.
+	uint8_t *data = nullptr;
+	size_t   size = 0;
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	LARGE_INTEGER file_size;
+	SYSTEM_INFO   info;
+	GetFileSizeEx(file, &file_size);
+	GetSystemInfo(&info);
+	size = (size_t)file_size.QuadPart;
+	if (size % info.dwPageSize != 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			data = (uint8_t *)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int file = open(filename, O_RDONLY);
+	if (file == -1)
+		return nullptr;
+	struct stat file_info;
+	fstat(file, &file_info);
+	size = (size_t)file_info.st_size;
+	if (size % (size_t)sysconf(_SC_PAGESIZE) != 0) {
+		data = (uint8_t *)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (data == (uint8_t *)MAP_FAILED)
+			data = nullptr;
+	}
+	close(file);
+#endif
+
+	int32_t i = _fgn_arr_add(&mem->regions, 1, mem->region_ct, mem->region_cap);
+	_fgn_mem_region_t &region = mem->regions[i];
+	if (data != nullptr) {
+		region.start  = data;
+		region.size   = size;
+		region.mapped = true;
+		if (out_size != nullptr) *out_size = size;
+		return (char *)data;
+	}
+
+	// Fall back to reading the file into a buffer the library owns
+	FILE *fp = nullptr;
+	if (fopen_s(&fp, filename, "rb") != 0 || fp == nullptr) {
+		mem->region_ct -= 1;
+		return nullptr;
+	}
+	// The file can be shorter than it said it was by now, so its size is
+	// what actually got read.
+	region.start = (uint8_t *)malloc(size + 1);
+	region.size  = size + 1;
+	region.used  = size + 1;
+	size = fread(region.start, 1, size, fp);
+	region.start[size] = '\0';
+	fclose(fp);
+	if (out_size != nullptr) *out_size = size;
+	return (char *)region.start;
+}
+void        _fgn_mem_release (_fgn_mem_t *mem, const void *file) {
+	for (int32_t i = mem->region_ct - 1; i >= 0; i--) {
+		if (mem->regions[i].start != file) continue;
+		_fgn_mem_region_free(mem->regions[i]);
+		memmove(&mem->regions[i], &mem->regions[i + 1], sizeof(_fgn_mem_region_t) * (mem->region_ct - i - 1));
+		mem->region_ct -= 1;
+		return;
+	}
+}
+template<typename T> int32_t _fgn_mem_arr_add  (_fgn_mem_t *mem, T **arr, int32_t quantity, int32_t &count, int32_t &capacity) {
+	// Library owned arrays store their capacity as ~capacity, so it's
+	// always negative, and grow by moving into a fresh allocation rather
+	// than realloc.
+	assert(capacity <= 0);
+	int32_t cap    = capacity < 0 ? ~capacity : 0;
+	int32_t result = count;
+	count += quantity;
+	if (count >= cap) {
+		int32_t new_cap = cap*2 > count ? cap * 2 : count+1;
+		T      *new_arr = (T*)_fgn_mem_alloc(mem, sizeof(T) * new_cap);
+		if (result > 0)
+			memcpy(new_arr, *arr, sizeof(T) * result);
+		*arr     = new_arr;
+		capacity = ~new_cap;
+	}
+	(*arr)[result] = {};
+	return result;
+}
+template<typename T> int32_t _fgn_graph_arr_add(const fgn_graph_t &graph, T **arr, int32_t quantity, int32_t &count, int32_t &capacity) {
+	return capacity < 0 || (_fgn_graph_arena(graph) && capacity == 0)
+		? _fgn_mem_arr_add(graph.mem, arr, quantity, count, capacity)
+		: _fgn_arr_add    (           arr, quantity, count, capacity);
+}
+
 #endif
 #endif
\ No newline at end of file
@@ -146,14 +146,14 @@ void fgne_draw(fgn_graph_t &graph, fgne_editor_state_t &state, const fgne_editor
 		for (int32_t i = 0; i < graph.node_ct; i++) {
 			ImGui::PushID(i);
 			if (config->shell_func(graph, i, node_state[i], config->meat_func)) {
-				fgn_node_t &node = fgn_graph_node_get(graph, i);
-				node.position[0] += ImGui::GetMouseDragDelta(0).x;
-				node.position[1] += ImGui::GetMouseDragDelta(0).y;
+				float *position = fgn_graph_node_position(graph, i);
+				position[0] += ImGui::GetMouseDragDelta(0).x;
+				position[1] += ImGui::GetMouseDragDelta(0).y;
 				ImGui::ResetMouseDragDelta(0);
-				if (node.position[0] < 0)
-					node.position[0] = 0;
-				if (node.position[1] < 0)
-					node.position[1] = 0;
+				if (position[0] < 0)
+					position[0] = 0;
+				if (position[1] < 0)
+					position[1] = 0;
 			}
 			ImGui::PopID();
 		}
@@ -186,7 +186,7 @@ void fgne_draw(fgn_graph_t &graph, fgne_editor_state_t &state, const fgne_editor
 	
 	// Draw line from the active node to the mouse
 	if (selected_in != -1) {
-		int32_t       ct = fgn_graph_node_get(graph, selected_in).in_ct;
+		int32_t       ct = fgn_graph_node_in_count(graph, selected_in);
 		editor_node_t &s = node_state[selected_in];
 		ImGui::GetWindowDrawList()->AddLine(
 			fgne_inouts_default(fgn_in, s.node_min, s.node_max, ct, ct+1),
@@ -194,7 +194,7 @@ void fgne_draw(fgn_graph_t &graph, fgne_editor_state_t &state, const fgne_editor
 			ImGui::GetColorU32({ 1,1,1,1 }));
 	}
 	if (selected_out != -1) {
-		int32_t       ct = fgn_graph_node_get(graph, selected_out).out_ct;
+		int32_t       ct = fgn_graph_node_out_count(graph, selected_out);
 		editor_node_t &s = node_state[selected_out];
 		ImGui::GetWindowDrawList()->AddLine(
 			fgne_inouts_default(fgn_out, s.node_min, s.node_max, ct, ct+1),
@@ -204,15 +204,19 @@ void fgne_draw(fgn_graph_t &graph, fgne_editor_state_t &state, const fgne_editor
 
 	// Delete items all the way at the end!
 	if (delete_node != -1) {
-		fgn_graph_node_delete(graph, delete_node);
-		if (selected_in > delete_node)
-			selected_in--;
-		if (selected_out > delete_node)
-			selected_out--;
-		if (selected_in == delete_node)
-			selected_in = -1;
-		if (selected_out == delete_node)
-			selected_out = -1;
+		// The remap tells us where everything we've kept track of moved to
+		int32_t       old_ct = graph.node_ct;
+		fgn_node_idx *remap  = (fgn_node_idx *)malloc(sizeof(fgn_node_idx) * old_ct);
+		fgn_graph_nodes_delete(graph, &delete_node, 1, remap);
+		if (selected_in != -1)
+			selected_in = remap[selected_in];
+		if (selected_out != -1)
+			selected_out = remap[selected_out];
+		for (int32_t i = 0; i < old_ct && i < node_state_ct; i++) {
+			if (remap[i] != -1)
+				node_state[remap[i]] = node_state[i];
+		}
+		free(remap);
 		delete_node = -1;
 	}
 	if (delete_edge != -1) {
@@ -235,7 +239,8 @@ bool fgne_shell_default(fgn_graph_t &graph, fgn_node_idx node_idx, editor_node_t
 	const float  frame_height = fmaxf(fminf(window->DC.CurrLineSize.y, g.FontSize + style.FramePadding.y*2), label_size.y + style.FramePadding.y*2);
 
 	// Begin the box
-	ImVec2 node_pos = { node.position[0],node.position[1] + frame_height };
+	float *position = fgn_graph_node_position(graph, node_idx);
+	ImVec2 node_pos = { position[0],position[1] + frame_height };
 	ImGui::SetCursorPos(node_pos);
 	ImGui::BeginGroup();
 
@@ -300,8 +305,8 @@ bool fgne_shell_default(fgn_graph_t &graph, fgn_node_idx node_idx, editor_node_t
 ///////////////////////////////////////////
 
 bool fgne_shell_circle(fgn_graph_t &graph, fgn_node_idx node_idx, editor_node_t &node_state, fgne_func_meat_t node_meat) {
-	fgn_node_t &node     = fgn_graph_node_get(graph, node_idx);
-	ImVec2      node_pos = { node.position[0], node.position[1] };
+	float      *position = fgn_graph_node_position(graph, node_idx);
+	ImVec2      node_pos = { position[0], position[1] };
 	ImGuiStyle &style    = ImGui::GetStyle();
 
 	// Draw the background
@@ -359,13 +364,15 @@ void fgne_draw_edge(const fgne_editor_config_t &config, fgn_graph_t &graph, fgn_
 	fgn_edge_t    &edge    = fgn_graph_edge_get(graph, edge_idx);
 	fgn_node_t    &start_n = fgn_graph_node_get(graph, edge.start);
 	fgn_node_t    &end_n   = fgn_graph_node_get(graph, edge.end);
+	int32_t        out_ct  = fgn_graph_node_out_count(graph, edge.start);
+	int32_t        in_ct   = fgn_graph_node_in_count (graph, edge.end);
 	editor_node_t &start   = node_state[edge.start];
 	editor_node_t &end     = node_state[edge.end];
 	int32_t start_i = 0, end_i = 0;
-	for (int32_t i = 0; i < start_n.out_ct; i++) if (start_n.out_edges[i] == edge_idx) { start_i = i; break; }
-	for (int32_t i = 0; i < end_n  .in_ct;  i++) if (end_n  .in_edges [i] == edge_idx) { end_i   = i; break; }
-	ImVec2 p1 = config.inout_func(fgn_out, start.node_min, start.node_max, start_i, start_n.out_ct+1);
-	ImVec2 p2 = config.inout_func(fgn_in,  end  .node_min, end  .node_max, end_i,   end_n  .in_ct +1);
+	for (int32_t i = 0; i < out_ct; i++) if (start_n.out_edges[i] == edge_idx) { start_i = i; break; }
+	for (int32_t i = 0; i < in_ct;  i++) if (end_n  .in_edges [i] == edge_idx) { end_i   = i; break; }
+	ImVec2 p1 = config.inout_func(fgn_out, start.node_min, start.node_max, start_i, out_ct+1);
+	ImVec2 p2 = config.inout_func(fgn_in,  end  .node_min, end  .node_max, end_i,   in_ct +1);
 
 	config.edge_func(graph, edge_idx, p1, p2);
 }
@@ -538,19 +545,15 @@ float dist_to_line_sq(ImVec2 a, ImVec2 b, ImVec2 pt) {
 ///////////////////////////////////////////
 
 void fgne_meat_kvps(fgn_graph_t &graph, fgn_node_idx node_idx) {
-	fgn_node_t &node = fgn_graph_node_get(graph, node_idx);
 	ImGui::PushItemWidth(150);
 
 	char new_value[512];
-	for (size_t i = 0; i < node.data.pair_ct; i++) {
-		sprintf_s(new_value, "%s", node.data.pairs[i].value);
-		if (ImGui::InputText(node.data.pairs[i].key, new_value, 512)) {
-			free(node.data.pairs[i].value);
-
-			size_t len = strlen(new_value);
-			node.data.pairs[i].value = (char*)malloc(len + 1); 
-			memcpy(node.data.pairs[i].value, new_value, len); 
-			node.data.pairs[i].value[len] = '\0'; 
+	if (fgn_graph_node_has_data(graph, node_idx)) {
+		fgn_data_t &data = fgn_graph_node_pairs(graph, node_idx);
+		for (size_t i = 0; i < data.pair_ct; i++) {
+			sprintf_s(new_value, "%s", data.pairs[i].value);
+			if (ImGui::InputText(data.pairs[i].key, new_value, 512))
+				fgn_data_set_value(data, (int32_t)i, new_value);
 		}
 	}
 	static char key_name[128] = {};
@@ -558,7 +561,7 @@ void fgne_meat_kvps(fgn_graph_t &graph, fgn_node_idx node_idx) {
 	ImGui::SameLine();
 	if (ImGui::Button("+")) {
 		if (strcmp(key_name,"") != 0)
-			fgn_data_add(node.data, key_name, "");
+			fgn_data_add(fgn_graph_node_pairs(graph, node_idx), key_name, "");
 		key_name[0] = '\0';
 	}
 
@@ -582,9 +585,9 @@ void fgne_meat_name(fgn_graph_t &graph, fgn_node_idx node_idx) {
 
 void  fgne_newnode_default(fgn_graph_t &graph, const char *id, ImVec2 pos) {
 	fgn_node_idx new_node = fgn_graph_node_add(graph, id);
-	fgn_node_t  &n        = fgn_graph_node_get(graph, new_node);
-	n.position[0] = pos.x;
-	n.position[1] = pos.y;
+	float       *position = fgn_graph_node_position(graph, new_node);
+	position[0] = pos.x;
+	position[1] = pos.y;
 }
 
 ///////////////////////////////////////////
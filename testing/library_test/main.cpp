@@ -16,10 +16,11 @@ void example1() {
 	fgn_lib_each(lib, [](fgn_graph_t &graph)
 	{
 		printf("Graph - %s\n", graph.id);
-		fgn_graph_node_each(graph, [](auto g, fgn_node_t &node)
+		for (int i = 0, ct = fgn_graph_node_count(graph); i < ct; i += 1)
 		{
-			printf("%s: [in:%d, out:%d, keys:%d]\n", node.id, node.in_ct, node.out_ct, node.data.pair_ct);
-		});
+			fgn_node_t &node = fgn_graph_node_get(graph, i);
+			printf("%s: [in:%d, out:%d, keys:%d]\n", node.id, fgn_graph_node_in_count(graph, i), fgn_graph_node_out_count(graph, i), fgn_graph_node_pair_count(graph, i));
+		}
 	});
 
 	fgn_destroy(lib);
@@ -32,11 +33,11 @@ void example2() {
 	fgn_graph_idx n1 = fgn_graph_node_add(graph, "Start");
 	fgn_graph_idx n2 = fgn_graph_node_add(graph, "Middle");
 	fgn_graph_idx n3 = fgn_graph_node_add(graph, "End");
-	fgn_data_add(fgn_graph_node_get(graph, n2).data, "cost", "100");
+	fgn_data_add(fgn_graph_node_pairs(graph, n2), "cost", "100");
 
 	fgn_graph_idx e1 = fgn_graph_edge_add(graph, n1, n2);
 	fgn_graph_idx e2 = fgn_graph_edge_add(graph, "Start", "End");
-	fgn_data_add(fgn_graph_edge_get(graph, e2).data, "distance", "5.1");
+	fgn_data_add(fgn_graph_edge_pairs(graph, e2), "distance", "5.1");
 
 	char *text_graph = fgn_save(graph);
 	printf("Output file:\n%s", text_graph);
@@ -67,7 +68,1074 @@ void example3() {
 	fgn_destroy(node_parser);
 }
 
-int main() {
+// The loader finds a line's separators with _fgn_scan_line, which has
+// a SIMD path. This checks it against a plain loop over the same lines,
+// starting at every offset across a couple of 32 byte blocks, and with
+// the range it may read cut off at every point along the line. Build
+// with FERR_GRAPHNET_NO_SIMD to run the scalar path, the checksum
+// printed should come out the same either way.
+void scan_line_reference(const char *str, const char *range_end, _fgn_line_t &line) {
+	line = {};
+	int32_t comma_ct = 0;
+	bool    q        = false;
+	for (; str != range_end && *str != '\0' && (q || (*str != '\n' && *str != '\r')); str++) {
+		if      (*str == '"') { q = !q; line.last_quote = str; }
+		else if (q)           continue;
+		else if (*str == ' ' && line.space == nullptr) line.space = str;
+		else if (*str == ':' && line.colon == nullptr) line.colon = str;
+		else if (*str == ',' && comma_ct < 2)          line.comma[comma_ct++] = str;
+	}
+	line.end = str;
+	if (line.space    == nullptr) line.space    = line.end;
+	if (line.colon    == nullptr) line.colon    = line.end;
+	if (line.comma[0] == nullptr) line.comma[0] = line.end;
+	if (line.comma[1] == nullptr) line.comma[1] = line.end;
+}
+bool test_scan_line() {
+	const char *lines[] = {
+		"",
+		"\n",
+		"-n Node1",
+		"-e Start, End\r\n",
+		"-e \"Node, 1\", \"Node: 2\"\n-n next",
+		"\tdesc \"Multi-line \"\"da\nta\"\" in\na struct.\"\n",
+		"\tkey value: with, some, commas, and: colons",
+		"\"quoted id with spaces\": graph, data",
+		"\ttext \"unterminated, quote: runs to the end",
+		"0123456789012345678901234567890",
+		"01234567890123456789012345678901",
+		"012345678901234567890123456789012",
+		"\t0123456789012345678901234567 \"a\"",
+		"\t012345678901234567890123456789, \"b, c\": d\n",
+		"\tlong_key_name_here \"value, with: stuff\" and, more: here \"end\"",
+		"::::,,,,    \"\"\"\"\r",
+	};
+	alignas(64) char buffer[256];
+	int32_t  ct = 0, bad = 0;
+	uint64_t checksum = 0;
+	for (size_t l = 0; l < sizeof(lines)/sizeof(lines[0]); l++) {
+		size_t length = strlen(lines[l]);
+		for (size_t offset = 0; offset < 64 && offset + length + 1 <= sizeof(buffer); offset++) {
+			// Separators past the terminator shouldn't be picked up
+			memset(buffer, '"', sizeof(buffer));
+			memcpy(buffer + offset, lines[l], length + 1);
+			const char *str = buffer + offset;
+
+			// The last cut leaves the range open, like a serial load does.
+			// Starting the range at the string keeps the scanner off the
+			// block before it, starting it at the buffer lets it mask.
+			for (size_t cut = 0; cut <= length + 1; cut++) {
+				const char *range_start = cut % 2 == 0 ? str : buffer;
+				const char *range_end   = cut <= length ? str + cut : nullptr;
+				_fgn_line_t line, ref;
+				_fgn_scan_line     (str, range_start, range_end, line);
+				scan_line_reference(str,      range_end, ref);
+				ct++;
+				if (memcmp(&line, &ref, sizeof(line)) != 0) {
+					bad++;
+					printf("scan_line mismatch on line %d at offset %d, cut at %d\n", (int)l, (int)offset, (int)cut);
+				}
+				const char *found[] = { line.end, line.space, line.colon, line.comma[0], line.comma[1], line.last_quote };
+				for (size_t f = 0; f < sizeof(found)/sizeof(found[0]); f++)
+					checksum = (checksum ^ (uint64_t)(found[f] == nullptr ? -1 : found[f] - str)) * 1099511628211;
+			}
+		}
+	}
+	printf("scan_line: %d of %d lines match, checksum %llx\n", ct - bad, ct, (unsigned long long)checksum);
+	return bad == 0;
+}
+
+// Floats get written with the fewest digits that parse back to the same
+// bits, and parsed with exact rounding. This checks the writer against
+// the shortest %g that strtof turns back into the same float, and the
+// parser against strtof, including decimals right on the halfway point
+// between two floats.
+int32_t float_digits(const char *text) {
+	char digits[32];
+	int32_t ct = 0;
+	for (; *text != '\0' && *text != 'e'; text++)
+		if (*text >= '0' && *text <= '9' && (ct > 0 || *text != '0')) digits[ct++] = *text;
+	while (ct > 0 && digits[ct - 1] == '0') ct--;
+	return ct;
+}
+bool test_float_round_trip() {
+	int32_t ct = 0, bad = 0;
+	auto check_write = [&](float value) {
+		char text[32], ref[32];
+		_fgn_float_write(value, text);
+		float   parsed   = _fgn_float_parse(text);
+		int32_t shortest = 1;
+		for (; shortest < 9; shortest++) {
+			snprintf(ref, sizeof(ref), "%.*g", shortest, value);
+			if (strtof(ref, nullptr) == value) break;
+		}
+		ct++;
+		if (memcmp(&parsed, &value, sizeof(float)) != 0 || float_digits(text) > shortest) {
+			bad++;
+			printf("float write mismatch on %.9g: wrote %s\n", value, text);
+		}
+	};
+	auto check_parse = [&](const char *text) {
+		float parsed = _fgn_float_parse(text);
+		float ref    = strtof(text, nullptr);
+		ct++;
+		if (memcmp(&parsed, &ref, sizeof(float)) != 0) {
+			bad++;
+			printf("float parse mismatch on %s: got %.9g, not %.9g\n", text, parsed, ref);
+		}
+	};
+	// Checks the exact halfway point between a float and the next one up,
+	// which rounds to whichever is even, and a hair either side of it.
+	auto check_tie = [&](float value) {
+		double mid = ((double)value + (double)nextafterf(value, INFINITY)) * 0.5;
+		if (value == FLT_MAX) mid = (double)FLT_MAX + ldexp(1.0, 103);
+		char text[256];
+		snprintf(text, sizeof(text), "%.150e", mid);                    check_parse(text);
+		snprintf(text, sizeof(text), "%.17g", nextafter(mid, 0.0));      check_parse(text);
+		snprintf(text, sizeof(text), "%.17g", nextafter(mid, INFINITY)); check_parse(text);
+	};
+
+	const float values[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 0.2f, 0.3f, 1.0f / 3.0f, 100.0f, 123456.0f, 16777216.0f, 1e10f, 3.14159265f, 1.5e-10f,
+		FLT_MAX, -FLT_MAX, FLT_MIN, FLT_EPSILON, INFINITY, -INFINITY, nextafterf(FLT_MIN, 0.0f), nextafterf(0.0f, 1.0f), nextafterf(FLT_MAX, 0.0f) };
+	for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); i++) {
+		check_write(values[i]);
+		if (values[i] >= 0 && values[i] < INFINITY) check_tie(values[i]);
+	}
+	// Every power of 2 and 10 floats can get near, and the subnormals
+	for (int32_t e = -149; e <= 127; e++) { check_write(ldexpf(1.0f, e)); check_tie(ldexpf(1.0f, e)); }
+	for (int32_t e = -45;  e <= 38;  e++) {
+		char text[32];
+		snprintf(text, sizeof(text), "1e%d", e);
+		check_parse(text);
+		check_write(strtof(text, nullptr));
+	}
+	for (uint32_t bits = 1; bits < 0x00800000; bits = bits * 3 + 1) {
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		check_write(value);
+		check_tie(value);
+	}
+	const char *texts[] = { "16777217", "16777219", "0.000000000000000000000000000000000000000000000700649232162408535", "3.4028235677973366e38", "3.4028235677973362e38",
+		"1.00000005960464477539062500000000000000000000000000000001", "0.1000000000000000000000000000000000000000000000000000000000000000000001", "  12.5", "-7e-3", "+2E+3" };
+	for (size_t i = 0; i < sizeof(texts)/sizeof(texts[0]); i++)
+		check_parse(texts[i]);
+
+	// And a random sample of everything else, skipping NaNs
+	uint32_t state = 12345;
+	for (int32_t i = 0; i < 50000; i++) {
+		state = state * 1664525u + 1013904223u;
+		uint32_t bits = state;
+		float    value;
+		memcpy(&value, &bits, sizeof(value));
+		if (value != value) continue;
+		check_write(value);
+		if (i % 8 == 0 && value >= 0 && value < INFINITY) check_tie(value);
+	}
+	printf("float round trip: %d of %d match\n", ct - bad, ct);
+	return bad == 0;
+}
+
+// A library with a bit of everything in it, for the tests below to
+// save, load and parse. parsed_t's fields are set on some of the nodes.
+struct parsed_t { float slider; float position[3]; };
+void make_parser(fgn_parser_t &parser) {
+	parser = {};
+	fgn_parser_create<parsed_t>(parser);
+	fgn_parser_add(parser, "slider",   offsetof(parsed_t, slider),   fgn_parse_float,  fgn_write_float);
+	fgn_parser_add(parser, "position", offsetof(parsed_t, position), fgn_parse_float3, fgn_write_float3);
+}
+void make_test_lib(fgn_library_t &lib, int32_t graph_ct) {
+	const char *words[] = {"Value", "1.337", "", "Use a microphone!", "\n1 0 0 0\n0 1 0 0", "Some \"text\" with quotes, ouch!", "A \\ slash"};
+	fgn_data_add(lib.data, "version", "1");
+	for (int32_t g = 0; g < graph_ct; g++) {
+		char name[32];
+		snprintf(name, sizeof(name), "Graph %d", g);
+		fgn_graph_t &graph = fgn_lib_get(lib, fgn_lib_add(lib, name));
+		fgn_data_add(graph.data, "desc", words[g % 3]);
+		for (int32_t n = 0; n < 200 * (g % 3); n++) {
+			snprintf(name, sizeof(name), "Node%d", n);
+			fgn_node_idx idx = fgn_graph_node_add(graph, name);
+			fgn_graph_node_position(graph, idx)[0] = n * 0.5f;
+			if (n % 3 == 0) fgn_graph_node_data<parsed_t>(graph, idx).slider = n * 0.25f;
+			for (int32_t k = 0; k < n % 4; k++)
+				fgn_data_add(fgn_graph_node_pairs(graph, idx), "Key", words[(n + k) % (sizeof(words)/sizeof(words[0]))]);
+		}
+		for (int32_t e = 0; e < 300 * (g % 3); e++) {
+			fgn_edge_idx idx = fgn_graph_edge_add(graph, (e * 7) % graph.node_ct, (e * 13 + 1) % graph.node_ct);
+			if (e % 5 == 0) fgn_data_add(fgn_graph_edge_pairs(graph, idx), "weight", words[e % 3]);
+		}
+	}
+}
+
+// Text and binary files should hold exactly the same thing: a library
+// saved to binary and loaded back has to save to the same text.
+bool test_binary_round_trip() {
+	fgn_parser_t parser;
+	fgn_library_t lib = {};
+	make_parser(parser);
+	make_test_lib(lib, 3);
+
+	char *text = fgn_save(lib, &parser);
+	bool  ok   = fgn_save_binary(lib, "round_trip.fgnb", &parser) == 0;
+	fgn_library_t loaded = {};
+	ok = ok && fgn_load_binary(loaded, "round_trip.fgnb") == 0;
+	char *loaded_text = ok ? fgn_save(loaded) : nullptr;
+	ok = ok && strcmp(text, loaded_text) == 0;
+	printf("binary round trip: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(loaded_text);
+	fgn_destroy(lib);
+	fgn_destroy(loaded);
+	fgn_destroy(parser);
+	return ok;
+}
+
+// Broken .fgnb files should fail to load rather than read outside the
+// file. Truncated ones always fail, and ones with bytes flipped either
+// fail or load something that still saves. Failing leaves the library's
+// memory as it was, with no file kept around in it.
+bool test_binary_corrupt() {
+	FILE *fp = nullptr;
+	if (fopen_s(&fp, "round_trip.fgnb", "rb") != 0 && fp == nullptr)
+		return false;
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	uint8_t *file = (uint8_t *)malloc(size);
+	fread(file, size, 1, fp);
+	fclose(fp);
+
+	int32_t loads = 0;
+	auto load = [&loads](const uint8_t *data, long length) {
+		FILE *out = nullptr;
+		if (fopen_s(&out, "corrupt.fgnb", "wb") != 0 && out == nullptr)
+			return -1;
+		fwrite(data, length, 1, out);
+		fclose(out);
+		fgn_library_t lib = {};
+		if (loads++ % 2 == 1) fgn_lib_use_arena(lib);
+		int32_t regions = lib.mem == nullptr ? -1 : lib.mem->region_ct;
+		int32_t result  = fgn_load_binary(lib, "corrupt.fgnb");
+		if (result != 0 && (lib.mem == nullptr ? -1 : lib.mem->region_ct) != regions)
+			result = -1;
+		if (result == 0) free(fgn_save(lib));
+		fgn_destroy(lib);
+		return (int)result;
+	};
+
+	int32_t bad = 0, failed = 0, tries = 0;
+	for (long length = 0; length < size; length += 1 + length / 8, tries++) {
+		int32_t result = load(file, length);
+		if (result != 2 && result != 3) bad++;
+	}
+	srand(1337);
+	for (int32_t i = 0; i < 200; i++, tries++) {
+		long    at  = rand() % size;
+		uint8_t old = file[at];
+		file[at] ^= (uint8_t)(1 << (rand() % 8));
+		int32_t result = load(file, size);
+		if (result != 0 && result != 3) bad++;
+		if (result == 3) failed++;
+		file[at] = old;
+	}
+	printf("binary corrupt: %d loads, %d flipped files rejected, %d bad results\n", tries, failed, bad);
+	free(file);
+	return bad == 0;
+}
+
+// Loading on several threads should give the same library as loading
+// on one, graphs in the same order and all.
+bool test_parallel_load() {
+	fgn_parser_t parser;
+	fgn_library_t lib = {};
+	make_parser(parser);
+	make_test_lib(lib, 12);
+	char *text = fgn_save(lib, &parser);
+
+	fgn_library_t serial = {}, parallel = {};
+	bool  ok            = fgn_load(serial, text, 1) == 0 && fgn_load(parallel, text, 4) == 0;
+	char *serial_text   = fgn_save(serial);
+	char *parallel_text = fgn_save(parallel);
+	ok = ok && parallel.graph_ct == lib.graph_ct && strcmp(serial_text, text) == 0 && strcmp(parallel_text, text) == 0;
+	printf("parallel load: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(serial_text);
+	free(parallel_text);
+	fgn_destroy(lib);
+	fgn_destroy(serial);
+	fgn_destroy(parallel);
+	fgn_destroy(parser);
+	return ok;
+}
+
+// With fgn_lib_share_values, values added from code should get shared
+// the same as loaded ones do, and mapped or parallel loads should share
+// as much as a plain load does. The library's own pair gets loaded by
+// the main thread, so graphs from the others only share with it if their
+// dictionaries got folded into the library's.
+bool test_share_values() {
+	fgn_library_t lib = {};
+	fgn_lib_share_values(lib);
+	fgn_data_add(lib.data, "color", "blue");
+	for (int32_t g = 0; g < 4; g++) {
+		char name[32];
+		snprintf(name, sizeof(name), "Shared%d", g);
+		fgn_graph_t &graph = fgn_lib_get(lib, fgn_lib_add(lib, name));
+		fgn_data_add(graph.data, "color", "blue");
+		for (int32_t n = 0; n < 100; n++) {
+			snprintf(name, sizeof(name), "Node%d", n);
+			fgn_node_idx idx = fgn_graph_node_add(graph, name);
+			fgn_data_add(fgn_graph_node_pairs(graph, idx), "color", n % 10 == 0 ? "red" : "blue");
+			if (n > 0) fgn_data_add(fgn_graph_edge_pairs(graph, fgn_graph_edge_add(graph, n - 1, n)), "color", "blue");
+		}
+	}
+
+	fgn_graph_t      &graph = lib.graphs[0];
+	fgn_value_stats_t stats = fgn_lib_value_stats(lib);
+	bool ok = stats.value_ct == 801 && stats.unique_ct == 2 && fgn_graph_node_pairs(graph, 1).pairs[0].value == graph.data.pairs[0].value;
+	printf("share values: %lld values, %lld unique\n", (long long)stats.value_ct, (long long)stats.unique_ct);
+
+	char *text = fgn_save(lib);
+	FILE *fp   = nullptr;
+	if (fopen_s(&fp, "shared.fgn", "w") != 0 || fp == nullptr)
+		ok = false;
+	if (fp != nullptr) { fputs(text, fp); fclose(fp); }
+	for (int32_t load = 0; load < 4; load++) {
+		fgn_library_t loaded = {};
+		fgn_lib_share_values(loaded);
+		int32_t threads = load % 2 == 0 ? 1 : 4;
+		int32_t result  = load < 2
+			? fgn_load            (loaded, text,         threads)
+			: fgn_load_file_mapped(loaded, "shared.fgn", threads);
+		fgn_value_stats_t loaded_stats = fgn_lib_value_stats(loaded);
+		if (result != 0 || loaded_stats.value_ct != stats.value_ct || loaded_stats.unique_ct != stats.unique_ct) {
+			printf("share values: %s load on %d threads has %lld unique\n", load < 2 ? "text" : "mapped", threads, (long long)loaded_stats.unique_ct);
+			ok = false;
+		}
+		fgn_destroy(loaded);
+	}
+	free(text);
+	fgn_destroy(lib);
+	return ok;
+}
+
+// Binary and mapped loads leave their pair lists in library memory. A
+// text load on top of them adds to those lists, and should end up with
+// the same library as two text loads would.
+bool test_mixed_load() {
+	fgn_parser_t parser;
+	fgn_library_t lib = {};
+	make_parser(parser);
+	make_test_lib(lib, 3);
+	char *text = fgn_save(lib, &parser);
+	bool  ok   = fgn_save_binary(lib, "mixed.fgnb", &parser) == 0;
+	FILE *fp   = nullptr;
+	if (fopen_s(&fp, "mixed.fgn", "w") != 0 && fp == nullptr)
+		ok = false;
+	if (fp != nullptr) { fputs(text, fp); fclose(fp); }
+
+	fgn_library_t ref = {}, binary = {}, mapped = {};
+	ok = ok && fgn_load(ref, text) == 0 && fgn_load(ref, text) == 0;
+	ok = ok && fgn_load_binary     (binary, "mixed.fgnb") == 0 && fgn_load(binary, text) == 0;
+	ok = ok && fgn_load_file_mapped(mapped, "mixed.fgn")  == 0 && fgn_load(mapped, text) == 0;
+	char *ref_text    = fgn_save(ref);
+	char *binary_text = fgn_save(binary);
+	char *mapped_text = fgn_save(mapped);
+	ok = ok && strcmp(binary_text, ref_text) == 0 && strcmp(mapped_text, ref_text) == 0;
+	printf("mixed load: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(ref_text);
+	free(binary_text);
+	free(mapped_text);
+	fgn_destroy(lib);
+	fgn_destroy(ref);
+	fgn_destroy(binary);
+	fgn_destroy(mapped);
+	fgn_destroy(parser);
+	return ok;
+}
+
+// A mapped load of a file with errors can't keep anything pointing into
+// it, so the library and its memory should look like before the load.
+bool test_mapped_errors() {
+	fgn_library_t lib = {};
+	make_test_lib(lib, 3);
+	char *text = fgn_save(lib);
+	FILE *fp   = nullptr;
+	bool  ok   = true;
+	if (fopen_s(&fp, "mapped_bad.fgn", "w") != 0 || fp == nullptr)
+		ok = false;
+	if (fp != nullptr) { fprintf(fp, "name Bad\n%s-g Broken\n-x nope\n", text); fclose(fp); }
+
+	fgn_library_t fresh = {}, mapped = {};
+	ok = ok && fgn_load_file_mapped(fresh, "mapped_bad.fgn", 4) != 0 && fresh.mem == nullptr && fresh.graph_ct == 0 && fresh.data.pair_ct == 0;
+	ok = ok && fgn_load_file_mapped(mapped, "mixed.fgn") == 0;
+	int32_t regions = mapped.mem == nullptr ? -1 : mapped.mem->region_ct;
+	char   *before  = fgn_save(mapped);
+	for (int32_t threads = 1; ok && threads <= 4; threads *= 4)
+		ok = fgn_load_file_mapped(mapped, "mapped_bad.fgn", threads) != 0 && mapped.mem->region_ct == regions;
+	char *after = fgn_save(mapped);
+	ok = ok && strcmp(before, after) == 0;
+	printf("mapped errors: %s\n", ok ? "rolled back" : "kept");
+
+	free(text);
+	free(before);
+	free(after);
+	fgn_destroy(lib);
+	fgn_destroy(fresh);
+	fgn_destroy(mapped);
+	return ok;
+}
+
+// Parsing everything after a lazy parse should only parse what hasn't
+// been yet, structs already parsed on access (and edits to them) stay.
+bool test_lazy_then_parse() {
+	fgn_parser_t parser;
+	fgn_library_t lib = {};
+	make_parser(parser);
+	make_test_lib(lib, 3);
+	char *text = fgn_save(lib, &parser);
+
+	fgn_library_t ref = {}, lazy = {};
+	bool ok = fgn_load(ref, text) == 0 && fgn_load(lazy, text) == 0;
+	fgn_parse     (ref,  &parser);
+	fgn_parse_lazy(lazy, &parser);
+	fgn_graph_t &graph = lazy.graphs[1];
+	for (int32_t n = 0; n < graph.node_ct; n += 2)
+		fgn_graph_node_data<parsed_t>(graph, n);
+	fgn_graph_node_data<parsed_t>(graph,          3).slider = 42;
+	fgn_graph_node_data<parsed_t>(ref.graphs[1], 3).slider = 42;
+	fgn_parse(lazy, &parser);
+
+	char *ref_text  = fgn_save(ref,  &parser);
+	char *lazy_text = fgn_save(lazy, &parser);
+	ok = ok && strcmp(ref_text, lazy_text) == 0 && graph.node_structs.parsed == nullptr;
+	printf("lazy then parse: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(ref_text);
+	free(lazy_text);
+	fgn_destroy(lib);
+	fgn_destroy(ref);
+	fgn_destroy(lazy);
+	fgn_destroy(parser);
+	return ok;
+}
+
+// A graph keeps one struct type for nodes and one for edges. Asking for
+// another size should come back empty, and not touch what's there.
+bool test_struct_size() {
+	fgn_graph_t graph = {};
+	fgn_graph_node_add(graph, "Node0");
+	fgn_graph_node_add(graph, "Node1");
+	fgn_graph_edge_add(graph, 0, 1);
+	fgn_graph_node_data<parsed_t>(graph, 1).slider = 5;
+	fgn_graph_edge_data<parsed_t>(graph, 0).slider = 6;
+
+	bool ok =
+		fgn_graph_node_data      <double>(graph, "Node1") == nullptr &&
+		fgn_graph_node_data_array<double>(graph)          == nullptr &&
+		fgn_graph_edge_data_array<double>(graph)          == nullptr &&
+		fgn_graph_node_data      <parsed_t>(graph, "Node1")->slider == 5 &&
+		fgn_graph_node_data_array<parsed_t>(graph)[1].slider        == 5 &&
+		fgn_graph_edge_data_array<parsed_t>(graph)[0].slider        == 6;
+	// Const graphs read the structs that are already there
+	const fgn_graph_t &const_graph = graph;
+	ok = ok &&
+		fgn_graph_node_data<parsed_t>(const_graph, 1      ).slider  == 5 &&
+		fgn_graph_node_data<parsed_t>(const_graph, "Node1")->slider == 5 &&
+		fgn_graph_edge_data<parsed_t>(const_graph, 0      ).slider  == 6;
+	printf("struct size: %s\n", ok ? "kept" : "overwritten");
+	fgn_destroy(graph);
+	return ok;
+}
+
+// A parser made from fgn_fields should parse and save exactly like the
+// same fields added by hand with fgn_parser_add.
+struct fielded_t { int32_t count; float slider; float position[3]; };
+static constexpr auto fielded_fields = fgn_fields(
+	fgn_field<&fielded_t::slider  >("slider"),
+	fgn_field<&fielded_t::position>("position"),
+	fgn_field<&fielded_t::count   >("count"));
+bool test_fields_round_trip() {
+	fgn_parser_t fields = {}, by_hand = {};
+	fgn_parser_create<fielded_fields>(fields);
+	fgn_parser_create<fielded_t>(by_hand);
+	fgn_parser_add(by_hand, "slider",   offsetof(fielded_t, slider),   fgn_parse_float,  fgn_write_float);
+	fgn_parser_add(by_hand, "position", offsetof(fielded_t, position), fgn_parse_float3, fgn_write_float3);
+	fgn_parser_add(by_hand, "count",    offsetof(fielded_t, count),    fgn_parse_int32,  fgn_write_int32);
+
+	fgn_graph_t graph = {};
+	fgn_graph_set_id(graph, "Fields");
+	for (int32_t n = 0; n < 100; n++) {
+		char name[32], value[64];
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_node_idx idx  = fgn_graph_node_add(graph, name);
+		fgn_data_t  &data = fgn_graph_node_pairs(graph, idx);
+		snprintf(value, sizeof(value), "%d", n * 7 - 50);
+		if (n % 2 == 0) fgn_data_add(data, "count", value);
+		snprintf(value, sizeof(value), "%g", n * 0.1f);
+		if (n % 3 == 0) fgn_data_add(data, "slider", value);
+		snprintf(value, sizeof(value), "%g,%g,%g", n * 1.5f, -n * 0.25f, 1.0f / (n + 1));
+		if (n % 5 != 0) fgn_data_add(data, "position", value);
+		if (n % 4 == 0) fgn_data_add(data, "other", "kept");
+	}
+	char *text = fgn_save(graph);
+
+	fgn_library_t a = {}, b = {};
+	bool ok = fgn_load(a, text) == 0 && fgn_load(b, text) == 0;
+	fgn_parse(a, &fields);
+	fgn_parse(b, &by_hand);
+	for (int32_t i = 0; ok && i < fields.item_ct; i++)
+		ok = fields.items[i].offset == by_hand.items[i].offset;
+	ok = ok && memcmp(a.graphs[0].node_structs.data, b.graphs[0].node_structs.data, sizeof(fielded_t) * 100) == 0;
+	// The fields parser saves through its generated writer
+	ok = ok && fields.write_struct != nullptr && by_hand.write_struct == nullptr;
+	char *a_text = fgn_save(a, &fields);
+	char *b_text = fgn_save(b, &by_hand);
+	ok = ok && strcmp(a_text, b_text) == 0;
+
+	// And what it saved should come back the same
+	fgn_library_t c = {};
+	ok = ok && fgn_load(c, a_text) == 0;
+	fgn_parse(c, &fields);
+	char *c_text = fgn_save(c, &fields);
+	ok = ok && strcmp(a_text, c_text) == 0 && fgn_graph_node_data<fielded_t>(c.graphs[0], 98).count == 98 * 7 - 50;
+	printf("fields round trip: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(a_text);
+	free(b_text);
+	free(c_text);
+	fgn_destroy(graph);
+	fgn_destroy(a);
+	fgn_destroy(b);
+	fgn_destroy(c);
+	fgn_destroy(fields);
+	fgn_destroy(by_hand);
+	return ok;
+}
+
+// Handles should follow their node or edge through every kind of edit,
+// including deletes that move the last one into the gap, and resolve
+// to -1 once it's gone. This runs random edits and checks every handle
+// ever made against a plain list of what should be alive.
+bool test_handles() {
+	struct item_t { fgn_handle_t handle; bool alive; int32_t start, end; };
+	const int32_t max_ct = 4000;
+	item_t *nodes = (item_t *)calloc(max_ct, sizeof(item_t));
+	item_t *edges = (item_t *)calloc(max_ct, sizeof(item_t));
+	int32_t node_ct = 0, edge_ct = 0, alive_nodes = 0, alive_edges = 0, bad = 0;
+
+	fgn_graph_t graph = {};
+	fgn_graph_set_id(graph, "Handles");
+	fgn_graph_use_handles(graph);
+	char name[32];
+	auto kill_edges_of = [&](int32_t n) {
+		for (int32_t e = 0; e < edge_ct; e++) {
+			if (edges[e].alive && (edges[e].start == n || edges[e].end == n)) { edges[e].alive = false; alive_edges--; }
+		}
+	};
+	auto random_alive = [&](item_t *items, int32_t ct) {
+		for (int32_t tries = 0; tries < 64; tries++) {
+			int32_t i = rand() % ct;
+			if (items[i].alive) return i;
+		}
+		return -1;
+	};
+
+	srand(42);
+	for (int32_t step = 0; step < 3000 && node_ct < max_ct && edge_ct < max_ct; step++) {
+		int32_t op = rand() % 10;
+		if (op < 3 || alive_nodes < 2) {
+			snprintf(name, sizeof(name), "Node%d", node_ct);
+			nodes[node_ct] = { fgn_graph_node_handle(graph, fgn_graph_node_add(graph, name)), true, -1, -1 };
+			node_ct++; alive_nodes++;
+		} else if (op < 6) {
+			int32_t a = random_alive(nodes, node_ct), b = random_alive(nodes, node_ct);
+			if (a == -1 || b == -1 || a == b) continue;
+			fgn_edge_idx e = fgn_graph_edge_add(graph, fgn_graph_node_resolve(graph, nodes[a].handle), fgn_graph_node_resolve(graph, nodes[b].handle));
+			snprintf(name, sizeof(name), "%d", edge_ct);
+			fgn_data_add(fgn_graph_edge_pairs(graph, e), "n", name);
+			edges[edge_ct] = { fgn_graph_edge_handle(graph, e), true, a, b };
+			edge_ct++; alive_edges++;
+		} else if (op < 8) {
+			int32_t e = edge_ct > 0 ? random_alive(edges, edge_ct) : -1;
+			if (e == -1) continue;
+			fgn_graph_edge_delete(graph, fgn_graph_edge_resolve(graph, edges[e].handle));
+			edges[e].alive = false; alive_edges--;
+		} else if (op < 9) {
+			int32_t n = random_alive(nodes, node_ct);
+			if (n == -1) continue;
+			fgn_graph_node_delete(graph, fgn_graph_node_resolve(graph, nodes[n].handle));
+			nodes[n].alive = false; alive_nodes--;
+			kill_edges_of(n);
+		} else {
+			// A batch, which compacts instead of swapping
+			fgn_node_idx batch[4];
+			int32_t      batch_ct = 0;
+			for (int32_t i = 0; i < 4; i++) {
+				int32_t n = random_alive(nodes, node_ct);
+				if (n == -1) continue;
+				batch[batch_ct++] = fgn_graph_node_resolve(graph, nodes[n].handle);
+				nodes[n].alive = false; alive_nodes--;
+				kill_edges_of(n);
+			}
+			fgn_graph_nodes_delete(graph, batch, batch_ct);
+		}
+
+		if (graph.node_ct != alive_nodes || graph.edge_ct != alive_edges) bad++;
+		for (int32_t n = 0; n < node_ct; n++) {
+			fgn_node_idx idx = fgn_graph_node_resolve(graph, nodes[n].handle);
+			snprintf(name, sizeof(name), "Node%d", n);
+			if (nodes[n].alive ? (idx < 0 || idx >= graph.node_ct || strcmp(graph.nodes[idx].id, name) != 0) : idx != -1) bad++;
+		}
+		for (int32_t e = 0; e < edge_ct; e++) {
+			fgn_edge_idx idx = fgn_graph_edge_resolve(graph, edges[e].handle);
+			if (!edges[e].alive) { if (idx != -1) bad++; continue; }
+			snprintf(name, sizeof(name), "%d", e);
+			if (idx < 0 || idx >= graph.edge_ct ||
+				graph.edges[idx].start != fgn_graph_node_resolve(graph, nodes[edges[e].start].handle) ||
+				graph.edges[idx].end   != fgn_graph_node_resolve(graph, nodes[edges[e].end  ].handle) ||
+				strcmp(fgn_data_value(fgn_graph_edge_pairs(graph, idx), "n"), name) != 0)
+				bad++;
+		}
+	}
+	printf("handles: %d nodes, %d edges made, %d bad lookups\n", node_ct, edge_ct, bad);
+
+	fgn_destroy(graph);
+	free(nodes);
+	free(edges);
+	return bad == 0;
+}
+
+// Parsing on several threads should give the same structs and leftover
+// pairs as parsing on one. One graph is big enough to be split into a
+// few ranges of its own.
+bool test_parallel_parse() {
+	fgn_parser_t parser;
+	fgn_library_t lib = {};
+	make_parser(parser);
+	make_test_lib(lib, 12);
+	fgn_graph_t &big = fgn_lib_get(lib, fgn_lib_add(lib, "Big"));
+	for (int32_t n = 0; n < 10000; n++) {
+		char name[32], value[32];
+		snprintf(name,  sizeof(name),  "Node%d", n);
+		snprintf(value, sizeof(value), "%g", n * 0.125f);
+		fgn_node_idx idx = fgn_graph_node_add(big, name);
+		if (n % 2 == 0) fgn_data_add(fgn_graph_node_pairs(big, idx), "slider", value);
+		if (n % 7 == 0) fgn_data_add(fgn_graph_node_pairs(big, idx), "Key",    value);
+		if (n > 0)      fgn_data_add(fgn_graph_edge_pairs(big, fgn_graph_edge_add(big, n - 1, n)), "position", "1,2,3");
+	}
+	char *text = fgn_save(lib, &parser);
+
+	fgn_library_t serial = {}, parallel = {};
+	bool ok = fgn_load(serial, text) == 0 && fgn_load(parallel, text) == 0;
+	fgn_parse(serial,   &parser, &parser, nullptr, 1);
+	fgn_parse(parallel, &parser, &parser, nullptr, 4);
+	for (int32_t g = 0; ok && g < serial.graph_ct; g++) {
+		const fgn_graph_t &a = serial.graphs[g], &b = parallel.graphs[g];
+		ok = memcmp(a.node_structs.data, b.node_structs.data, sizeof(parsed_t) * a.node_ct) == 0
+		  && memcmp(a.edge_structs.data, b.edge_structs.data, sizeof(parsed_t) * a.edge_ct) == 0;
+	}
+	char *serial_text   = fgn_save(serial,   &parser, &parser);
+	char *parallel_text = fgn_save(parallel, &parser, &parser);
+	ok = ok && strcmp(serial_text, parallel_text) == 0;
+	printf("parallel parse: %s\n", ok ? "same" : "different");
+
+	free(text);
+	free(serial_text);
+	free(parallel_text);
+	fgn_destroy(lib);
+	fgn_destroy(serial);
+	fgn_destroy(parallel);
+	fgn_destroy(parser);
+	return ok;
+}
+
+// Nodes keep their first few edges inline, so anything that moves nodes
+// has to re-point those lists. Every edge should show up once in its
+// start's out list and once in its end's in list, and inline lists
+// should point into their own node.
+bool check_adjacency(const fgn_graph_t &graph) {
+	int32_t *seen = (int32_t *)calloc(graph.edge_ct + 1, sizeof(int32_t));
+	bool     ok   = true;
+	for (int32_t n = 0; n < graph.node_ct; n++) {
+		const fgn_node_t &node = graph.nodes[n];
+		if (node.out_cap == 0 && node.out_edges != node._out_inline) ok = false;
+		if (node.in_cap  == 0 && node.in_edges  != node._in_inline ) ok = false;
+		for (int32_t i = 0; i < fgn_graph_node_out_count(graph, n); i++) {
+			fgn_edge_idx e = node.out_edges[i];
+			if (e < 0 || e >= graph.edge_ct || graph.edges[e].start != n || (seen[e] & 1)) ok = false;
+			else seen[e] |= 1;
+		}
+		for (int32_t i = 0; i < fgn_graph_node_in_count(graph, n); i++) {
+			fgn_edge_idx e = node.in_edges[i];
+			if (e < 0 || e >= graph.edge_ct || graph.edges[e].end != n || (seen[e] & 2)) ok = false;
+			else seen[e] |= 2;
+		}
+	}
+	for (int32_t e = 0; e < graph.edge_ct; e++)
+		if (seen[e] != 3) ok = false;
+	free(seen);
+	return ok;
+}
+bool test_inline_edges() {
+	fgn_library_t lib = {};
+	fgn_graph_t  &graph = fgn_lib_get(lib, fgn_lib_add(lib, "Inline"));
+	char name[32];
+	int32_t step = 0, bad = 0;
+	auto check = [&](const fgn_graph_t &g) { step++; if (!check_adjacency(g)) { bad++; printf("inline edges: bad after step %d\n", step); } };
+
+	// Out counts from 0 to 7, so lists both fit inline and spill over
+	for (int32_t n = 0; n < 50; n++) {
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_graph_node_add(graph, name);
+	}
+	for (int32_t n = 0; n < 50; n++)
+		for (int32_t k = 0; k < n % 8; k++)
+			fgn_graph_edge_add(graph, n, (n + k + 1) % 50);
+	check(graph);
+
+	// Growing the node array moves every node
+	for (int32_t n = 50; n < 2000; n++) {
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_graph_node_add(graph, name);
+		if (n % 3 == 0) fgn_graph_edge_add(graph, n, n % 50);
+	}
+	check(graph);
+
+	for (int32_t e = graph.edge_ct - 1; e >= 0; e -= 3)
+		fgn_graph_edge_delete(graph, e);
+	check(graph);
+
+	// Single deletes shift the nodes after, batches compact them
+	fgn_graph_node_delete(graph, 5);
+	check(graph);
+	fgn_node_idx batch[] = { 1, 10, 20, 1500 };
+	fgn_graph_nodes_delete(graph, batch, sizeof(batch)/sizeof(batch[0]));
+	check(graph);
+
+	// Loaded graphs, text and binary, get their lists pointed too
+	char *text = fgn_save(lib);
+	fgn_library_t text_lib = {}, binary_lib = {};
+	bool ok = fgn_load(text_lib, text) == 0 && fgn_save_binary(lib, "inline.fgnb") == 0 && fgn_load_binary(binary_lib, "inline.fgnb") == 0;
+	if (ok) {
+		check(text_lib.graphs[0]);
+		check(binary_lib.graphs[0]);
+		fgn_graph_edge_add(binary_lib.graphs[0], 0, 1);
+		fgn_graph_node_add(binary_lib.graphs[0], "Extra");
+		check(binary_lib.graphs[0]);
+	}
+
+	// With handles, deletes move the last node into the gap instead
+	fgn_graph_use_handles(graph);
+	for (int32_t n = 0; n < 40; n++)
+		fgn_graph_node_delete(graph, (n * 37) % graph.node_ct);
+	check(graph);
+
+	ok = ok && bad == 0;
+	printf("inline edges: %s\n", ok ? "linked" : "broken");
+	free(text);
+	fgn_destroy(lib);
+	fgn_destroy(text_lib);
+	fgn_destroy(binary_lib);
+	return ok;
+}
+
+// Hashes, positions and edge counts live in columns on the graph, and
+// pairs in a side table for every third node. All of them have to follow
+// their nodes through adds and deletes, and deleted nodes give their
+// side table entry back.
+bool check_columns(fgn_graph_t &graph) {
+	char    id[32];
+	int32_t data_ct = 0;
+	for (int32_t n = 0; n < graph.node_ct; n++) {
+		int32_t num = atoi(graph.nodes[n].id + 4);
+		snprintf(id, sizeof(id), "Node%d", num);
+		if (fgn_graph_node_findid(graph, id) != n || fgn_graph_node_hash(graph, n) != fgn_hash(id) || fgn_graph_node_position(graph, n)[0] != num * 2.0f)
+			return false;
+		if (fgn_graph_node_has_data(graph, n) != (num % 3 == 0))
+			return false;
+		if (num % 3 == 0) {
+			const char *name = fgn_data_value(fgn_graph_node_pairs(graph, n), "name");
+			if (name == nullptr || strcmp(name, id) != 0) return false;
+			data_ct++;
+		}
+		int32_t in_ct = 0, out_ct = 0;
+		for (int32_t e = 0; e < graph.edge_ct; e++) {
+			if (graph.edges[e].end   == n) in_ct++;
+			if (graph.edges[e].start == n) out_ct++;
+		}
+		if (fgn_graph_node_in_count(graph, n) != in_ct || fgn_graph_node_out_count(graph, n) != out_ct)
+			return false;
+	}
+	return graph.node_data_ct - graph.node_data_free_ct == data_ct && check_adjacency(graph);
+}
+bool test_columns() {
+	bool ok = true;
+	for (int32_t handles = 0; handles < 2; handles++) {
+		fgn_graph_t graph = {};
+		char id[32];
+		for (int32_t n = 0; n < 50; n++) {
+			snprintf(id, sizeof(id), "Node%d", n);
+			fgn_node_idx idx = fgn_graph_node_add(graph, id);
+			fgn_graph_node_position(graph, idx)[0] = n * 2.0f;
+			if (n % 3 == 0) fgn_data_add(fgn_graph_node_pairs(graph, idx), "name", id);
+			for (int32_t e = 1; e <= n % 4; e++)
+				fgn_graph_edge_add(graph, n, (e * 7) % n);
+			if (n == 30 && handles) fgn_graph_use_handles(graph);
+		}
+		for (int32_t n = 0; n < 10; n++)
+			fgn_graph_node_delete(graph, (n * 7) % graph.node_ct);
+		fgn_node_idx batch[] = { 1, 5, 9 };
+		fgn_graph_nodes_delete(graph, batch, 3);
+		fgn_edge_idx edges[] = { 0, 2 };
+		fgn_graph_edges_delete(graph, edges, graph.edge_ct > 2 ? 2 : 0);
+		ok = ok && graph.node_ct == 37 && check_columns(graph);
+		fgn_destroy(graph);
+	}
+	printf("columns: %s\n", ok ? "followed" : "lost");
+	return ok;
+}
+
+// Long pair lists look keys up through the index in their head, which
+// has to survive adds and removes on both owned and borrowed lists.
+bool check_long_pairs(fgn_data_t &data, int32_t first, int32_t last) {
+	char key[32];
+	for (int32_t k = 0; k < 80; k++) {
+		snprintf(key, sizeof(key), "key%d", k);
+		const char *value    = fgn_data_value(data, key);
+		bool        expected = k >= first && k < last && k % 3 != 0;
+		if ((value != nullptr) != expected || (value != nullptr && strcmp(value, key + 3) != 0))
+			return false;
+	}
+	return true;
+}
+void edit_long_pairs(fgn_data_t &data, int32_t first, int32_t last) {
+	char key[32];
+	for (int32_t k = first; k < last; k++) {
+		snprintf(key, sizeof(key), "key%d", k);
+		fgn_data_add(data, key, key + 3);
+	}
+	for (int32_t k = first; k < last; k++) {
+		snprintf(key, sizeof(key), "key%d", k);
+		if (k % 3 == 0) fgn_data_remove(data, key);
+	}
+}
+bool test_long_pairs() {
+	fgn_library_t lib = {};
+	fgn_graph_t  &graph = fgn_lib_get(lib, fgn_lib_add(lib, "Graph"));
+	edit_long_pairs(graph.data, 0, 40);
+	bool ok = sizeof(fgn_data_t) == sizeof(void *) * 2 + sizeof(int32_t) * 2 && check_long_pairs(graph.data, 0, 40);
+
+	fgn_library_t loaded = {};
+	ok = ok && fgn_save_binary(lib, "long_pairs.fgnb") == 0 && fgn_load_binary(loaded, "long_pairs.fgnb") == 0;
+	if (ok) {
+		fgn_data_t &data = fgn_lib_get(loaded, 0).data;
+		ok = check_long_pairs(data, 0, 40);
+		edit_long_pairs(data, 40, 80);
+		ok = ok && check_long_pairs(data, 0, 80);
+	}
+	printf("long pairs: %s\n", ok ? "found" : "lost");
+	fgn_destroy(lib);
+	fgn_destroy(loaded);
+	return ok;
+}
+
+// Run with "bench" as the first argument, and build with optimizations
+// on. This one times adding edges, walking them breadth first, and
+// destroying the graph, for a graph big enough that node layout and
+// allocations matter.
+int bench_edges() {
+	const int32_t node_ct = 1000000, edge_ct = 1500000;
+	fgn_graph_t graph = {};
+	fgn_graph_set_id(graph, "Bench");
+	char name[32];
+	for (int32_t n = 0; n < node_ct; n++) {
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_graph_node_add(graph, name);
+	}
+
+	srand(1337);
+	clock_t start = clock();
+	for (int32_t e = 0; e < edge_ct; e++) {
+		fgn_node_idx a = (fgn_node_idx)(((uint32_t)rand() << 15 ^ (uint32_t)rand()) % node_ct);
+		fgn_node_idx b = (fgn_node_idx)(((uint32_t)rand() << 15 ^ (uint32_t)rand()) % node_ct);
+		if (a != b) fgn_graph_edge_add(graph, a, b);
+	}
+	double add_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+	start = clock();
+	fgn_node_idx *queue   = (fgn_node_idx *)malloc(sizeof(fgn_node_idx) * node_ct);
+	uint8_t      *visited = (uint8_t      *)malloc(node_ct);
+	int64_t       reached = 0;
+	for (int32_t pass = 0; pass < 4; pass++) {
+		memset(visited, 0, node_ct);
+		int32_t head = 0, tail = 0;
+		queue[tail++] = pass;
+		visited[pass] = 1;
+		while (head < tail) {
+			fgn_node_idx      curr = queue[head++];
+			const fgn_node_t &node = graph.nodes[curr];
+			for (int32_t i = 0; i < graph.node_out_cts[curr]; i++) {
+				fgn_node_idx next = graph.edges[node.out_edges[i]].end;
+				if (!visited[next]) { visited[next] = 1; queue[tail++] = next; }
+			}
+			for (int32_t i = 0; i < graph.node_in_cts[curr]; i++) {
+				fgn_node_idx next = graph.edges[node.in_edges[i]].start;
+				if (!visited[next]) { visited[next] = 1; queue[tail++] = next; }
+			}
+		}
+		reached += tail;
+	}
+	double bfs_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	free(queue);
+	free(visited);
+
+	int32_t made = graph.edge_ct;
+	start = clock();
+	fgn_destroy(graph);
+	double destroy_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+	printf("bench edges: %d nodes, %d edges\n", node_ct, made);
+	printf("  edge adds: %8.1fms\n", add_ms);
+	printf("  4x bfs:    %8.1fms (%lld reached)\n", bfs_ms, (long long)reached);
+	printf("  destroy:   %8.1fms\n", destroy_ms);
+	return 0;
+}
+
+// Times parsing and saving the same nodes with a fgn_fields parser, and
+// with the same fields added by hand through fgn_parser_add.
+int bench_fields() {
+	const int32_t node_ct = 300000;
+	fgn_parser_t fields = {}, by_hand = {};
+	fgn_parser_create<fielded_fields>(fields);
+	fgn_parser_create<fielded_t>(by_hand);
+	fgn_parser_add(by_hand, "slider",   offsetof(fielded_t, slider),   fgn_parse_float,  fgn_write_float);
+	fgn_parser_add(by_hand, "position", offsetof(fielded_t, position), fgn_parse_float3, fgn_write_float3);
+	fgn_parser_add(by_hand, "count",    offsetof(fielded_t, count),    fgn_parse_int32,  fgn_write_int32);
+
+	fgn_graph_t graph = {};
+	fgn_graph_set_id(graph, "Fields");
+	for (int32_t n = 0; n < node_ct; n++) {
+		char name[32], value[64];
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_data_t &data = fgn_graph_node_pairs(graph, fgn_graph_node_add(graph, name));
+		snprintf(value, sizeof(value), "%d", n * 7 - 50);                                     fgn_data_add(data, "count",    value);
+		snprintf(value, sizeof(value), "%g", n * 0.1f);                                       fgn_data_add(data, "slider",   value);
+		snprintf(value, sizeof(value), "%g,%g,%g", n * 1.5f, -n * 0.25f, 1.0f / (n + 1)); fgn_data_add(data, "position", value);
+	}
+	char *text = fgn_save(graph);
+	fgn_destroy(graph);
+
+	// Alternating rounds, keeping the best time for each, so neither one
+	// gets the warm caches or a quiet machine to itself
+	const fgn_parser_t *parsers[] = { &by_hand, &fields };
+	const char         *names  [] = { "fgn_parser_add", "fgn_fields" };
+	double parse_ms[2] = { 1e9, 1e9 }, save_ms[2] = { 1e9, 1e9 };
+	for (int32_t round = 0; round < 3; round++) {
+		for (int32_t p = 0; p < 2; p++) {
+			fgn_library_t lib = {};
+			fgn_load(lib, text);
+			clock_t start = clock();
+			fgn_parse(lib, parsers[p]);
+			double ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+			if (ms < parse_ms[p]) parse_ms[p] = ms;
+
+			start = clock();
+			free(fgn_save(lib, parsers[p]));
+			ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+			if (ms < save_ms[p]) save_ms[p] = ms;
+			fgn_destroy(lib);
+		}
+	}
+	printf("bench fields: %d nodes, 3 fields each, best of 3\n", node_ct);
+	for (int32_t p = 0; p < 2; p++)
+		printf("  %-14s parse: %6.1fms, save: %6.1fms\n", names[p], parse_ms[p], save_ms[p]);
+	free(text);
+	fgn_destroy(fields);
+	fgn_destroy(by_hand);
+	return 0;
+}
+
+// Times saving a big generated graph to text, in memory and to a file,
+// next to a plain memcpy of the same number of bytes for scale.
+int bench_save() {
+	const int32_t node_ct = 1000000, edge_ct = 1000000;
+	const char   *words[] = { "Value", "1.337", "Use a microphone!", "Here's some \"text\" with some quotes in it", "multi\nline" };
+	fgn_graph_t graph = {};
+	fgn_graph_set_id(graph, "Bench");
+	srand(1337);
+	char name[32];
+	for (int32_t n = 0; n < node_ct; n++) {
+		snprintf(name, sizeof(name), "Node%d", n);
+		fgn_node_idx idx = fgn_graph_node_add(graph, name);
+		fgn_data_add(fgn_graph_node_pairs(graph, idx), "Key", words[rand() % (sizeof(words)/sizeof(words[0]))]);
+		if (n % 3 == 0) {
+			float *pos = fgn_graph_node_position(graph, idx);
+			pos[0] = n * 0.5f;
+			pos[1] = -n / 7.0f;
+			pos[2] = rand() / (float)RAND_MAX;
+		}
+	}
+	for (int32_t e = 0; e < edge_ct; e++) {
+		fgn_node_idx a = (fgn_node_idx)(((uint32_t)rand() << 15 ^ (uint32_t)rand()) % node_ct);
+		fgn_node_idx b = (fgn_node_idx)(((uint32_t)rand() << 15 ^ (uint32_t)rand()) % node_ct);
+		if (a != b) fgn_graph_edge_add(graph, a, b);
+	}
+
+	clock_t start = clock();
+	char   *text  = fgn_save(graph);
+	double  save_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	size_t  size    = strlen(text);
+
+	start = clock();
+	fgn_save_file(graph, "bench_save.fgn");
+	double file_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+	// The copy's pages get touched first, so this is just the copy
+	char *copy = (char *)malloc(size + 1);
+	memset(copy, 1, size + 1);
+	start = clock();
+	memcpy(copy, text, size + 1);
+	double copy_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	int32_t check = copy[size / 2];
+
+	printf("bench save: %d nodes, %d edges, %.1fMB of text\n", graph.node_ct, graph.edge_ct, size / (1024.0 * 1024.0));
+	printf("  fgn_save:      %8.1fms (%.0fMB/s)\n", save_ms, size / (1024.0 * 1024.0) / (save_ms / 1000.0));
+	printf("  fgn_save_file: %8.1fms\n", file_ms);
+	printf("  memcpy:        %8.1fms (%d)\n", copy_ms, check);
+	free(text);
+	free(copy);
+	fgn_destroy(graph);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		return bench_edges() + bench_fields() + bench_save();
+
+	int32_t failed = 0;
+	if (!test_scan_line())         failed++;
+	if (!test_float_round_trip())  failed++;
+	if (!test_binary_round_trip()) failed++;
+	if (!test_binary_corrupt())    failed++;
+	if (!test_parallel_load())     failed++;
+	if (!test_share_values())      failed++;
+	if (!test_mixed_load())        failed++;
+	if (!test_mapped_errors())     failed++;
+	if (!test_lazy_then_parse())   failed++;
+	if (!test_struct_size())       failed++;
+	if (!test_fields_round_trip()) failed++;
+	if (!test_handles())           failed++;
+	if (!test_parallel_parse())    failed++;
+	if (!test_inline_edges())      failed++;
+	if (!test_long_pairs())        failed++;
+	if (!test_columns())           failed++;
 
 	example1();
 	example2();
@@ -110,7 +1178,7 @@ int main() {
 			char name[32];
 			sprintf_s(name, "Node%d", total_n++);
 			fgn_node_idx idx = fgn_graph_node_add(graph, name);
-			while (rand() % 2 == 0) fgn_data_add(fgn_graph_node_get(graph, idx).data, "Key", words[rand()%_countof(words)]);
+			while (rand() % 2 == 0) fgn_data_add(fgn_graph_node_pairs(graph, idx), "Key", words[rand()%_countof(words)]);
 			if    (rand() % 8 == 0) fgn_graph_node_data<node_data_t>(graph, idx).text = "Multi-line \"da\nta\" in\na struct.";
 		}
 
@@ -121,7 +1189,7 @@ int main() {
 			int end   = rand() % graph.node_ct;
 			while (end == start) end = rand() % ct;
 			fgn_edge_idx id = fgn_graph_edge_add(graph, start, end);
-			while (rand() % 2 == 0) fgn_data_add(fgn_graph_edge_get(graph, id).data, "Key", words[rand()%_countof(words)]);
+			while (rand() % 2 == 0) fgn_data_add(fgn_graph_edge_pairs(graph, id), "Key", words[rand()%_countof(words)]);
 			if    (rand() % 8 == 0) fgn_graph_edge_data<node_data_t>(graph, id).text = "Multi-line \"data\" in\na struct.";
 		}
 
@@ -147,5 +1215,5 @@ int main() {
 	fgn_destroy(lib);
 	fgn_destroy(graph);
 	fgn_destroy(node_parser);
-	return 0;
+	return failed;
 }
\ No newline at end of file